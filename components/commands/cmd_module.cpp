@@ -5,12 +5,16 @@
 #include "argtable3/argtable3.h"
 #include "esp_log.h"
 #include "module_config.h"
+#include "mqtt_config.h"
+#include "e131_config.h"
+#include "artnet_config.h"
 
 #define MODULE_CMD_TAG "MODULE"
 
 static struct {
     struct arg_lit *check;
     struct arg_int *led_number;
+    struct arg_str *strip_type;
     struct arg_end *end;
 } module_args;
 
@@ -28,10 +32,25 @@ static int handle_module(int argc, char** argv) {
     else {
       ESP_LOGI(MODULE_CMD_TAG, "No led number stored.");
     }
+    ws2812_type_t strip_type;
+    if (load_strip_type_from_nvs(&strip_type)) {
+      ESP_LOGI(MODULE_CMD_TAG, "Currently stored strip type : %s", strip_type_name(strip_type));
+    }
+    else {
+      ESP_LOGI(MODULE_CMD_TAG, "No strip type stored.");
+    }
   }
   if (module_args.led_number->count > 0) {
     save_led_number_to_nvs(*module_args.led_number->ival);
   }
+  if (module_args.strip_type->count > 0) {
+    ws2812_type_t strip_type;
+    if (!parse_strip_type(*module_args.strip_type->sval, &strip_type)) {
+      ESP_LOGE(MODULE_CMD_TAG, "Unknown strip type : %s", *module_args.strip_type->sval);
+      return 1;
+    }
+    save_strip_type_to_nvs(strip_type);
+  }
   return 0;
 }
 
@@ -39,7 +58,8 @@ void register_module()
 {
     module_args.check = arg_lit0("c", "check", "check current stored configuration");
     module_args.led_number = arg_int0("n", "numled", "<n>", "set led number");
-    module_args.end = arg_end(3);
+    module_args.strip_type = arg_str0("t", "type", "<type>", "set strip type : ws2812, ws2811, ws2813, sk6812 or sk6812_rgbw");
+    module_args.end = arg_end(4);
 
     esp_console_cmd_t module_cmd = { };
     module_cmd.command = "module";
@@ -50,3 +70,73 @@ void register_module()
 
     ESP_ERROR_CHECK( esp_console_cmd_register(&module_cmd) );
 }
+
+static struct {
+    struct arg_lit *reset;
+    struct arg_end *end;
+} stats_args;
+
+static int handle_stats(int argc, char** argv) {
+  int nerrors = arg_parse(argc, argv, (void**) &stats_args);
+  if (nerrors != 0) {
+      arg_print_errors(stderr, stats_args.end, argv[0]);
+      return 1;
+  }
+  ws2812_stats_t stats;
+  strip->getStats(&stats);
+  printf("Frames : %u (%u dropped, %u stalled)\n", stats.frames, get_dropped_frames(), stats.stalledFrames);
+  printf("Commands : %u (%u coalesced)\n", get_posted_commands(), get_coalesced_commands());
+  printf("Encode : %u us (max %u us)\n", stats.lastEncodeUs, stats.maxEncodeUs);
+  printf("Transmit : %u us (max %u us)\n", stats.lastTransmitUs, stats.maxTransmitUs);
+  printf("Interval : %u us (max %u us)\n", stats.lastIntervalUs, stats.maxIntervalUs);
+  printf("Encoded pixels : %u (%u total)\n", strip->getEncodedPixelCount(), strip->getTotalEncodedPixelCount());
+  printf("Power scale : %u/256 (%u mA estimated)\n", strip->getPowerScale(), strip->getEstimatedCurrent());
+  printf("Encode histogram :");
+  for (int i = 0; i < WS2812_STATS_BUCKETS - 1; i++) {
+    printf(" <%ius:%u", 64 << i, stats.encodeHistogram[i]);
+  }
+  printf(" more:%u\n", stats.encodeHistogram[WS2812_STATS_BUCKETS - 1]);
+  mqtt_reassembly_stats_t mqtt_stats;
+  get_mqtt_reassembly_stats(&mqtt_stats);
+  printf("MQTT messages : %u (%u fragmented, %u oversized, %u busy, %u incomplete)\n",
+    mqtt_stats.messages, mqtt_stats.fragmented, mqtt_stats.oversized, mqtt_stats.busy, mqtt_stats.incomplete);
+#if CONFIG_E131_RECEIVER
+  e131_stats_t e131_stats;
+  get_e131_stats(&e131_stats);
+  printf("E1.31 : %u frames (%u dropped), %u packets (%u out of sequence), %u syncs\n",
+    e131_stats.frames, e131_stats.dropped, e131_stats.packets, e131_stats.out_of_sequence, e131_stats.syncs);
+#endif
+#if CONFIG_ARTNET_NODE
+  artnet_stats_t artnet_stats;
+  get_artnet_stats(&artnet_stats);
+  printf("Art-Net : %u frames (%u dropped), %u packets (%u out of sequence), %u syncs, %u polls\n",
+    artnet_stats.frames, artnet_stats.dropped, artnet_stats.packets, artnet_stats.out_of_sequence,
+    artnet_stats.syncs, artnet_stats.polls);
+#endif
+  if (stats_args.reset->count > 0) {
+    reset_strip_stats();
+    reset_mqtt_reassembly_stats();
+#if CONFIG_E131_RECEIVER
+    reset_e131_stats();
+#endif
+#if CONFIG_ARTNET_NODE
+    reset_artnet_stats();
+#endif
+  }
+  return 0;
+}
+
+void register_stats()
+{
+    stats_args.reset = arg_lit0("r", "reset", "reset the stats after printing them");
+    stats_args.end = arg_end(2);
+
+    esp_console_cmd_t stats_cmd = { };
+    stats_cmd.command = "stats";
+    stats_cmd.help = "Print the strip frame timings and the network receive counters.";
+    stats_cmd.hint = NULL;
+    stats_cmd.func = &handle_stats;
+    stats_cmd.argtable = &stats_args;
+
+    ESP_ERROR_CHECK( esp_console_cmd_register(&stats_cmd) );
+}
@@ -1,2 +1,3 @@
 
 void register_module();
+void register_stats();
@@ -0,0 +1,222 @@
+#include "artnet_config.h"
+#include "module_config.h"
+#include "server_config.h"
+#include "dmx_config.h"
+#include "lwip/api.h"
+#include "tcpip_adapter.h"
+#include "esp_wifi.h"
+
+// Art-Net 4 op codes, sent little endian.
+#define ARTNET_OP_POLL 0x2000
+#define ARTNET_OP_POLL_REPLY 0x2100
+#define ARTNET_OP_DMX 0x5000
+#define ARTNET_OP_SYNC 0x5200
+
+// Offsets of the fields of the Art-Net packets.
+#define ARTNET_OP_CODE 8
+#define ARTNET_DMX_SEQUENCE 12
+#define ARTNET_DMX_PORT_ADDRESS 14
+#define ARTNET_DMX_LENGTH 16
+#define ARTNET_DMX_DATA 18
+#define ARTNET_SYNC_LENGTH 14
+#define ARTNET_MAX_LENGTH (ARTNET_DMX_DATA + DMX_UNIVERSE_SLOTS)
+
+#define ARTNET_POLL_REPLY_LENGTH 239
+
+// Frames are shown on ArtSync only while ArtSync packets keep coming.
+#define ARTNET_SYNC_TIMEOUT_MS 4000
+
+static const uint8_t artnet_id[8] = { 'A', 'r', 't', '-', 'N', 'e', 't', 0 };
+
+static TaskHandle_t artnet_task_handle = NULL;
+static volatile bool artnet_running = false;
+static artnet_stats_t artnet_stats = { };
+// Id of the device, in the names of the node.
+static int32_t device_number = 0;
+
+// Frame received from the universes mapped from the CONFIG_ARTNET_UNIVERSE port-address.
+static dmx_frame_t dmx;
+static TickType_t last_sync = 0;
+static bool synchronized = false;
+static uint8_t sequences[DMX_MAX_UNIVERSES];
+static uint32_t sequenced_universes = 0;
+
+// Packets split over several pbufs are copied here.
+static uint8_t packet_copy[ARTNET_MAX_LENGTH];
+
+/**
+ * Answers an ArtPoll with one ArtPollReply per mapped universe, each describing a
+ * single output port, as a node with more than 4 ports does.
+ */
+static void send_poll_replies(struct netconn* conn, const ip_addr_t* controller) {
+  tcpip_adapter_ip_info_t ip_info;
+  tcpip_adapter_get_ip_info(TCPIP_ADAPTER_IF_STA, &ip_info);
+  uint8_t mac[6];
+  esp_wifi_get_mac(WIFI_IF_STA, mac);
+
+  for (uint16_t i = 0; i < dmx.universe_count; i++) {
+    struct netbuf* buf = netbuf_new();
+    uint8_t* reply = (uint8_t*) netbuf_alloc(buf, ARTNET_POLL_REPLY_LENGTH);
+    if (reply == NULL) {
+      netbuf_delete(buf);
+      return;
+    }
+    uint16_t port_address = CONFIG_ARTNET_UNIVERSE + i;
+    memset(reply, 0, ARTNET_POLL_REPLY_LENGTH);
+    memcpy(reply, artnet_id, sizeof(artnet_id));
+    reply[8] = ARTNET_OP_POLL_REPLY & 0xff;
+    reply[9] = ARTNET_OP_POLL_REPLY >> 8;
+    memcpy(reply + 10, &ip_info.ip.addr, 4);
+    reply[14] = ARTNET_PORT & 0xff;
+    reply[15] = ARTNET_PORT >> 8;
+    reply[18] = (port_address >> 8) & 0x7f; // Net
+    reply[19] = (port_address >> 4) & 0x0f; // Sub-Net
+    reply[23] = 0xc0;                       // Indicators in normal mode
+    snprintf((char*) reply + 26, 18, "PixLed %i", device_number);
+    snprintf((char*) reply + 44, 64, "PixLed module %i, %i pixels", device_number, num_led);
+    snprintf((char*) reply + 108, 64, "#0001 [%04u] Universe %i", artnet_stats.polls % 10000, port_address);
+    reply[173] = 1;                         // One port
+    reply[174] = 0x80;                      // Outputs DMX512 from Art-Net
+    reply[182] = 0x80;                      // Output transmitting
+    reply[190] = port_address & 0x0f;       // Universe of the output
+    memcpy(reply + 201, mac, sizeof(mac));
+    memcpy(reply + 207, &ip_info.ip.addr, 4);
+    reply[211] = i + 1;                     // Bind index of the port
+    reply[212] = 0x08;                      // 15 bit port-addresses
+    netconn_sendto(conn, buf, controller, ARTNET_PORT);
+    netbuf_delete(buf);
+  }
+}
+
+static void handle_dmx_packet(const uint8_t* packet, size_t length) {
+  if (length < ARTNET_DMX_DATA) {
+    return;
+  }
+  uint16_t port_address = (packet[ARTNET_DMX_PORT_ADDRESS + 1] & 0x7f) << 8 | packet[ARTNET_DMX_PORT_ADDRESS];
+  uint16_t index = port_address - CONFIG_ARTNET_UNIVERSE;
+  if (index >= dmx.universe_count) {
+    return;
+  }
+  // A sequence of 0 disables the check, it otherwise goes from 1 to 255.
+  uint8_t sequence = packet[ARTNET_DMX_SEQUENCE];
+  uint32_t bit = (uint32_t) 1 << index;
+  if (sequence != 0) {
+    int8_t step = sequence - sequences[index];
+    if ((sequenced_universes & bit) && step <= 0 && step > -20) {
+      artnet_stats.out_of_sequence++;
+      return;
+    }
+    sequences[index] = sequence;
+    sequenced_universes |= bit;
+  }
+  artnet_stats.packets++;
+
+  size_t slots = packet[ARTNET_DMX_LENGTH] << 8 | packet[ARTNET_DMX_LENGTH + 1];
+  if (slots > length - ARTNET_DMX_DATA) {
+    slots = length - ARTNET_DMX_DATA;
+  }
+  dmx_frame_write(&dmx, index, packet + ARTNET_DMX_DATA, slots);
+
+  if (synchronized && xTaskGetTickCount() - last_sync > pdMS_TO_TICKS(ARTNET_SYNC_TIMEOUT_MS)) {
+    ESP_LOGI(ARTNET_TAG, "No more ArtSync, showing the frames as they arrive");
+    synchronized = false;
+  }
+  if (!synchronized && dmx_frame_is_complete(&dmx)) {
+    dmx_frame_post(&dmx);
+  }
+}
+
+static void handle_sync_packet(size_t length) {
+  if (length < ARTNET_SYNC_LENGTH) {
+    return;
+  }
+  artnet_stats.syncs++;
+  last_sync = xTaskGetTickCount();
+  synchronized = true;
+  // The universes of the frame are shown together, the frame is dropped if some are missing,
+  // the strip keeping the previous frame.
+  dmx_frame_post(&dmx);
+}
+
+static void handle_packet(struct netconn* conn, struct netbuf* buf, const uint8_t* packet, size_t length) {
+  if (length < ARTNET_OP_CODE + 2 || memcmp(packet, artnet_id, sizeof(artnet_id)) != 0) {
+    return;
+  }
+  switch (packet[ARTNET_OP_CODE] | packet[ARTNET_OP_CODE + 1] << 8) {
+    case ARTNET_OP_DMX:
+      handle_dmx_packet(packet, length);
+      break;
+    case ARTNET_OP_SYNC:
+      handle_sync_packet(length);
+      break;
+    case ARTNET_OP_POLL:
+      artnet_stats.polls++;
+      send_poll_replies(conn, netbuf_fromaddr(buf));
+      break;
+  }
+}
+
+/**
+ * Receives the Art-Net packets. The packets are read in place from the lwIP
+ * buffers, and the DMX slots copied once, into the frame buffer.
+ */
+static void artnet_task(void* arg) {
+  struct netconn* conn = netconn_new(NETCONN_UDP);
+  netconn_bind(conn, IP_ADDR_ANY, ARTNET_PORT);
+  netconn_set_recvtimeout(conn, 100);
+  ESP_LOGI(ARTNET_TAG, "Listening to port-addresses %i to %i", CONFIG_ARTNET_UNIVERSE, CONFIG_ARTNET_UNIVERSE + dmx.universe_count - 1);
+
+  while (artnet_running) {
+    dmx_frame_expire(&dmx);
+    struct netbuf* buf;
+    if (netconn_recv(conn, &buf) != ERR_OK) {
+      continue;
+    }
+    void* data;
+    u16_t length;
+    netbuf_data(buf, &data, &length);
+    if (length == netbuf_len(buf)) {
+      handle_packet(conn, buf, (const uint8_t*) data, length);
+    } else {
+      length = netbuf_copy(buf, packet_copy, sizeof(packet_copy));
+      handle_packet(conn, buf, packet_copy, length);
+    }
+    netbuf_delete(buf);
+  }
+
+  dmx_frame_release(&dmx);
+  netconn_delete(conn);
+  artnet_task_handle = NULL;
+  vTaskDelete(NULL);
+}
+
+void start_artnet() {
+  if (artnet_task_handle != NULL) {
+    return;
+  }
+  load_id_from_nvs(&device_number);
+  dmx_frame_init(&dmx, CONFIG_ARTNET_START_CHANNEL);
+  sequenced_universes = 0;
+  synchronized = false;
+  artnet_running = true;
+  xTaskCreate(artnet_task, "artnet", 3072, NULL, 9, &artnet_task_handle);
+}
+
+void stop_artnet() {
+  artnet_running = false;
+  while (artnet_task_handle != NULL) {
+    vTaskDelay(pdMS_TO_TICKS(10));
+  }
+}
+
+void get_artnet_stats(artnet_stats_t* stats) {
+  *stats = artnet_stats;
+  stats->frames = dmx.frames;
+  stats->dropped = dmx.dropped;
+}
+
+void reset_artnet_stats() {
+  artnet_stats = { };
+  dmx.frames = 0;
+  dmx.dropped = 0;
+}
@@ -0,0 +1,19 @@
+#include "main.h"
+
+#define ARTNET_TAG "ARTNET"
+#define ARTNET_PORT 6454
+
+// Counters of the Art-Net node.
+typedef struct {
+  uint32_t packets;         // ArtDmx packets received for the mapped universes
+  uint32_t frames;          // Frames posted to the strip
+  uint32_t dropped;         // Frames dropped, incomplete or without a free frame buffer
+  uint32_t out_of_sequence; // ArtDmx packets discarded because older than the previous one
+  uint32_t syncs;           // ArtSync packets received
+  uint32_t polls;           // ArtPoll packets answered
+} artnet_stats_t;
+
+void start_artnet();
+void stop_artnet();
+void get_artnet_stats(artnet_stats_t* stats);
+void reset_artnet_stats();
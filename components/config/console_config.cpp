@@ -107,6 +107,7 @@ void initialize_console() {
   register_mqtt();
   register_server();
   register_module();
+  register_stats();
 
   xTaskCreate(command_line_task, "command line", CONSOLE_STACK_SIZE, NULL, 10, &command_line_task_handler);
 }
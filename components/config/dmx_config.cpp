@@ -0,0 +1,125 @@
+#include "dmx_config.h"
+#include "module_config.h"
+
+/**
+ * Maps the strip to the universes, from the given channel of the first one.
+ * @param[out] dmx Frame to initialize
+ * @param[in] start_channel DMX channel of the first pixel, from 1 to 512
+ */
+void dmx_frame_init(dmx_frame_t* dmx, uint16_t start_channel) {
+  uint8_t channels = strip->getChannelCount();
+  size_t frame_bytes = num_led * channels;
+  *dmx = { };
+  dmx->start_channel = start_channel;
+  dmx->first_universe_slots = (DMX_UNIVERSE_SLOTS - (start_channel - 1)) / channels * channels;
+  dmx->universe_slots = DMX_UNIVERSE_SLOTS / channels * channels;
+  dmx->universe_count = 1;
+  if (frame_bytes > dmx->first_universe_slots) {
+    dmx->universe_count += (frame_bytes - dmx->first_universe_slots + dmx->universe_slots - 1) / dmx->universe_slots;
+  }
+  if (dmx->universe_count > DMX_MAX_UNIVERSES) {
+    ESP_LOGW(DMX_TAG, "The strip needs %i universes, only the first %i are mapped", dmx->universe_count, DMX_MAX_UNIVERSES);
+    dmx->universe_count = DMX_MAX_UNIVERSES;
+  }
+  dmx->all_universes = dmx->universe_count == 32 ? 0xffffffff : ((uint32_t) 1 << dmx->universe_count) - 1;
+}
+
+/**
+ * Gives up a frame whose universes did not all arrive.
+ */
+static void drop_frame(dmx_frame_t* dmx) {
+  if (dmx->frame != NULL) {
+    release_frame_buffer();
+    dmx->frame = NULL;
+  }
+  dmx->dropped++;
+  dmx->received_universes = 0;
+}
+
+/**
+ * Copies the slots of a universe into the frame. A universe received twice starts
+ * the next frame, and the current one is dropped.
+ * @param[in] index Index of the universe, from 0 to universe_count - 1
+ * @param[in] slots DMX slots of the universe, without the start code
+ * @param[in] count Number of slots
+ */
+void dmx_frame_write(dmx_frame_t* dmx, uint16_t index, const uint8_t* slots, size_t count) {
+  uint32_t bit = (uint32_t) 1 << index;
+  if (dmx->received_universes & bit) {
+    drop_frame(dmx);
+  }
+  if (dmx->received_universes == 0) {
+    dmx->started = xTaskGetTickCount();
+    if (dmx->frame == NULL) {
+      dmx->frame = acquire_frame_buffer(&dmx->frame_size);
+    }
+  }
+  if (dmx->frame != NULL) {
+    size_t slot = index == 0 ? dmx->start_channel - 1 : 0;
+    size_t offset = index == 0 ? 0 : dmx->first_universe_slots + (index - 1) * dmx->universe_slots;
+    size_t length = index == 0 ? dmx->first_universe_slots : dmx->universe_slots;
+    size_t available = count > slot ? count - slot : 0;
+    if (length > available) {
+      length = available;
+    }
+    if (offset + length > dmx->frame_size) {
+      length = offset < dmx->frame_size ? dmx->frame_size - offset : 0;
+    }
+    memcpy(dmx->frame + offset, slots + slot, length);
+  }
+  dmx->received_universes |= bit;
+}
+
+bool dmx_frame_is_complete(dmx_frame_t* dmx) {
+  return dmx->received_universes == dmx->all_universes;
+}
+
+/**
+ * Posts the frame to the render task, once its universes are all there or on a
+ * synchronization packet. A frame missing some universes is dropped rather than
+ * completed with the universes of an older frame, left in the frame buffer: the
+ * strip keeps showing the previous frame as a whole. Frames that could not get a
+ * frame buffer are counted as dropped too.
+ */
+void dmx_frame_post(dmx_frame_t* dmx) {
+  if (dmx->received_universes == 0) {
+    return;
+  }
+  if (!dmx_frame_is_complete(dmx)) {
+    drop_frame(dmx);
+    return;
+  }
+  if (dmx->frame != NULL) {
+    post_frame(dmx->frame_size);
+    dmx->frame = NULL;
+    dmx->frames++;
+  } else {
+    dmx->dropped++;
+  }
+  dmx->received_universes = 0;
+}
+
+/**
+ * Drops the frame being received once it is DMX_FRAME_TIMEOUT_MS old, when its
+ * other universes or its synchronization did not come. The frame buffer is
+ * otherwise held, and the other posters turned away, until the next whole frame.
+ * Called by the receivers before each receive, so also after their timeouts.
+ */
+void dmx_frame_expire(dmx_frame_t* dmx) {
+  if (dmx->received_universes != 0
+      && xTaskGetTickCount() - dmx->started > pdMS_TO_TICKS(DMX_FRAME_TIMEOUT_MS)) {
+    ESP_LOGD(DMX_TAG, "Dropping a frame missing some universes");
+    drop_frame(dmx);
+  }
+}
+
+/**
+ * Gives up the frame being received, when the receiver stops.
+ */
+void dmx_frame_release(dmx_frame_t* dmx) {
+  if (dmx->frame != NULL) {
+    release_frame_buffer();
+    dmx->frame = NULL;
+  }
+  dmx->received_universes = 0;
+}
@@ -0,0 +1,37 @@
+#include "main.h"
+
+#define DMX_TAG "DMX"
+#define DMX_UNIVERSE_SLOTS 512
+
+// Universes that can be mapped to the strip, 32 of 170 RGB pixels.
+#define DMX_MAX_UNIVERSES 32
+
+// Age after which a frame still missing some universes, or its synchronization, is
+// dropped and its frame buffer given back.
+#define DMX_FRAME_TIMEOUT_MS 100
+
+// Frame assembled from the DMX universes mapped to the strip. The pixels start at a
+// channel of the first universe, and go on from the first channel of the next
+// universes. Pixels do not straddle universes, 170 RGB or 128 RGBW pixels fit in one.
+// The slots are written straight into the next frame buffer, which is held from the
+// first universe of a frame until the frame is posted, dropped or expired.
+typedef struct {
+  uint16_t start_channel;
+  uint16_t universe_count;
+  uint16_t first_universe_slots;
+  uint16_t universe_slots;
+  uint32_t all_universes;
+  uint32_t received_universes;
+  TickType_t started; // Arrival of the first universe of the frame
+  uint8_t* frame;
+  size_t frame_size;
+  uint32_t frames;  // Frames posted to the strip
+  uint32_t dropped; // Frames dropped, incomplete or without a free frame buffer
+} dmx_frame_t;
+
+void dmx_frame_init(dmx_frame_t* dmx, uint16_t start_channel);
+void dmx_frame_write(dmx_frame_t* dmx, uint16_t index, const uint8_t* slots, size_t count);
+bool dmx_frame_is_complete(dmx_frame_t* dmx);
+void dmx_frame_post(dmx_frame_t* dmx);
+void dmx_frame_expire(dmx_frame_t* dmx);
+void dmx_frame_release(dmx_frame_t* dmx);
@@ -0,0 +1,216 @@
+#include "e131_config.h"
+#include "module_config.h"
+#include "dmx_config.h"
+#include "lwip/api.h"
+
+// Offsets of the fields of the E1.31 packets (ANSI E1.31-2016), all big endian.
+#define E131_ACN_IDENTIFIER 4
+#define E131_ROOT_VECTOR 18
+#define E131_FRAMING_VECTOR 40
+#define E131_DATA_SYNC_ADDRESS 109
+#define E131_DATA_SEQUENCE 111
+#define E131_DATA_OPTIONS 112
+#define E131_DATA_UNIVERSE 113
+#define E131_DMP_VECTOR 117
+#define E131_DMP_COUNT 123
+#define E131_DATA_START_CODE 125
+#define E131_DATA_SLOTS 126
+#define E131_SYNC_ADDRESS 45
+#define E131_SYNC_LENGTH 49
+#define E131_MAX_LENGTH (E131_DATA_SLOTS + DMX_UNIVERSE_SLOTS)
+
+#define VECTOR_ROOT_E131_DATA 0x00000004
+#define VECTOR_ROOT_E131_EXTENDED 0x00000008
+#define VECTOR_E131_DATA_PACKET 0x00000002
+#define VECTOR_E131_EXTENDED_SYNCHRONIZATION 0x00000001
+#define VECTOR_DMP_SET_PROPERTY 0x02
+
+#define E131_OPTION_PREVIEW 0x80
+#define E131_OPTION_TERMINATED 0x40
+
+static const uint8_t acn_identifier[12] = { 'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0 };
+
+static TaskHandle_t e131_task_handle = NULL;
+static volatile bool e131_running = false;
+static e131_stats_t e131_stats = { };
+
+// Frame received from the universes mapped from CONFIG_E131_UNIVERSE.
+static dmx_frame_t dmx;
+static uint16_t sync_address = 0;
+static uint8_t sequences[DMX_MAX_UNIVERSES];
+static uint32_t sequenced_universes = 0;
+
+// Packets split over several pbufs are copied here.
+static uint8_t packet_copy[E131_MAX_LENGTH];
+
+static uint16_t read16(const uint8_t* data) {
+  return data[0] << 8 | data[1];
+}
+
+static uint32_t read32(const uint8_t* data) {
+  return (uint32_t) data[0] << 24 | data[1] << 16 | data[2] << 8 | data[3];
+}
+
+/**
+ * Joins or leaves the multicast group of a universe, 239.255.<universe high>.<universe low>.
+ * lwIP counts the joins of each group, a universe joined twice is left twice.
+ */
+static void join_leave_universe(struct netconn* conn, uint16_t universe, enum netconn_igmp join_or_leave) {
+  ip_addr_t group;
+  IP_ADDR4(&group, 239, 255, universe >> 8, universe & 0xff);
+  if (netconn_join_leave_group(conn, &group, IP_ADDR_ANY, join_or_leave) != ERR_OK) {
+    ESP_LOGW(E131_TAG, "Could not %s the group of universe %i", join_or_leave == NETCONN_JOIN ? "join" : "leave", universe);
+  }
+}
+
+static void handle_data_packet(struct netconn* conn, const uint8_t* packet, size_t length) {
+  if (length < E131_DATA_SLOTS
+      || read32(packet + E131_FRAMING_VECTOR) != VECTOR_E131_DATA_PACKET
+      || packet[E131_DMP_VECTOR] != VECTOR_DMP_SET_PROPERTY) {
+    return;
+  }
+  uint16_t index = read16(packet + E131_DATA_UNIVERSE) - CONFIG_E131_UNIVERSE;
+  if (index >= dmx.universe_count) {
+    return;
+  }
+  uint32_t bit = (uint32_t) 1 << index;
+  if (packet[E131_DATA_OPTIONS] & (E131_OPTION_PREVIEW | E131_OPTION_TERMINATED)) {
+    return;
+  }
+  // Packets up to 20 sequence numbers older than the previous one are discarded.
+  uint8_t sequence = packet[E131_DATA_SEQUENCE];
+  int8_t step = sequence - sequences[index];
+  if ((sequenced_universes & bit) && step <= 0 && step > -20) {
+    e131_stats.out_of_sequence++;
+    return;
+  }
+  sequences[index] = sequence;
+  sequenced_universes |= bit;
+  if (packet[E131_DATA_START_CODE] != 0) {
+    return;
+  }
+  e131_stats.packets++;
+
+  // The property value count includes the start code.
+  size_t slots = read16(packet + E131_DMP_COUNT);
+  slots = slots > 0 ? slots - 1 : 0;
+  if (slots > length - E131_DATA_SLOTS) {
+    slots = length - E131_DATA_SLOTS;
+  }
+  dmx_frame_write(&dmx, index, packet + E131_DATA_SLOTS, slots);
+
+  uint16_t address = read16(packet + E131_DATA_SYNC_ADDRESS);
+  // Only the group of the current synchronization address is joined.
+  if (address != sync_address) {
+    if (sync_address != 0) {
+      join_leave_universe(conn, sync_address, NETCONN_LEAVE);
+    }
+    if (address != 0) {
+      join_leave_universe(conn, address, NETCONN_JOIN);
+    }
+  }
+  sync_address = address;
+  if (sync_address == 0 && dmx_frame_is_complete(&dmx)) {
+    dmx_frame_post(&dmx);
+  }
+}
+
+static void handle_sync_packet(const uint8_t* packet, size_t length) {
+  if (length < E131_SYNC_LENGTH
+      || read32(packet + E131_FRAMING_VECTOR) != VECTOR_E131_EXTENDED_SYNCHRONIZATION) {
+    return;
+  }
+  e131_stats.syncs++;
+  // The universes of the frame are latched together, the frame is dropped if some are missing.
+  if (sync_address != 0 && read16(packet + E131_SYNC_ADDRESS) == sync_address) {
+    dmx_frame_post(&dmx);
+  }
+}
+
+static void handle_packet(struct netconn* conn, const uint8_t* packet, size_t length) {
+  if (length < E131_FRAMING_VECTOR + 4
+      || memcmp(packet + E131_ACN_IDENTIFIER, acn_identifier, sizeof(acn_identifier)) != 0) {
+    return;
+  }
+  switch (read32(packet + E131_ROOT_VECTOR)) {
+    case VECTOR_ROOT_E131_DATA:
+      handle_data_packet(conn, packet, length);
+      break;
+    case VECTOR_ROOT_E131_EXTENDED:
+      handle_sync_packet(packet, length);
+      break;
+  }
+}
+
+/**
+ * Receives the E1.31 packets of the mapped universes. The packets are read in place
+ * from the lwIP buffers, and their slots copied once, into the frame buffer.
+ */
+static void e131_task(void* arg) {
+  struct netconn* conn = netconn_new(NETCONN_UDP);
+  netconn_bind(conn, IP_ADDR_ANY, E131_PORT);
+  netconn_set_recvtimeout(conn, 100);
+  for (uint16_t i = 0; i < dmx.universe_count; i++) {
+    join_leave_universe(conn, CONFIG_E131_UNIVERSE + i, NETCONN_JOIN);
+  }
+  ESP_LOGI(E131_TAG, "Listening to universes %i to %i", CONFIG_E131_UNIVERSE, CONFIG_E131_UNIVERSE + dmx.universe_count - 1);
+
+  while (e131_running) {
+    dmx_frame_expire(&dmx);
+    struct netbuf* buf;
+    if (netconn_recv(conn, &buf) != ERR_OK) {
+      continue;
+    }
+    void* data;
+    u16_t length;
+    netbuf_data(buf, &data, &length);
+    if (length == netbuf_len(buf)) {
+      handle_packet(conn, (const uint8_t*) data, length);
+    } else {
+      length = netbuf_copy(buf, packet_copy, sizeof(packet_copy));
+      handle_packet(conn, packet_copy, length);
+    }
+    netbuf_delete(buf);
+  }
+
+  dmx_frame_release(&dmx);
+  for (uint16_t i = 0; i < dmx.universe_count; i++) {
+    join_leave_universe(conn, CONFIG_E131_UNIVERSE + i, NETCONN_LEAVE);
+  }
+  if (sync_address != 0) {
+    join_leave_universe(conn, sync_address, NETCONN_LEAVE);
+    sync_address = 0;
+  }
+  netconn_delete(conn);
+  e131_task_handle = NULL;
+  vTaskDelete(NULL);
+}
+
+void start_e131() {
+  if (e131_task_handle != NULL) {
+    return;
+  }
+  dmx_frame_init(&dmx, CONFIG_E131_START_CHANNEL);
+  sequenced_universes = 0;
+  e131_running = true;
+  xTaskCreate(e131_task, "e131", 3072, NULL, 9, &e131_task_handle);
+}
+
+void stop_e131() {
+  e131_running = false;
+  while (e131_task_handle != NULL) {
+    vTaskDelay(pdMS_TO_TICKS(10));
+  }
+}
+
+void get_e131_stats(e131_stats_t* stats) {
+  *stats = e131_stats;
+  stats->frames = dmx.frames;
+  stats->dropped = dmx.dropped;
+}
+
+void reset_e131_stats() {
+  e131_stats = { };
+  dmx.frames = 0;
+  dmx.dropped = 0;
+}
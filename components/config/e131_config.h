@@ -0,0 +1,18 @@
+#include "main.h"
+
+#define E131_TAG "E131"
+#define E131_PORT 5568
+
+// Counters of the E1.31 receiver.
+typedef struct {
+  uint32_t packets;         // Data packets received for the mapped universes
+  uint32_t frames;          // Frames posted to the strip
+  uint32_t dropped;         // Frames dropped, incomplete or without a free frame buffer
+  uint32_t out_of_sequence; // Data packets discarded because older than the previous one
+  uint32_t syncs;           // Synchronization packets received
+} e131_stats_t;
+
+void start_e131();
+void stop_e131();
+void get_e131_stats(e131_stats_t* stats);
+void reset_e131_stats();
@@ -1,16 +1,321 @@
+#include <atomic>
+#include <stdlib.h>
 #include "module_config.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "soc/soc.h"
 
 uint16_t num_led;
 WS2812* strip;
 
+// Names of the strip types, in ws2812_type_t order.
+static const char* strip_type_names[] = {
+  "ws2812", "ws2811", "ws2813", "sk6812", "sk6812_rgbw"
+};
+
+// Stack of the render task, in bytes. The first showAsync() allocates the second
+// output buffer and logs it, and the power limiter, the level table and the frame
+// copies run on this stack too. Its headroom is reported as render_stack_free.
+#define STRIP_RENDER_STACK_SIZE 4096
+static TaskHandle_t render_task = NULL;
+
+// Refresh periods missed by the render task.
+static volatile uint32_t dropped_frames = 0;
+
+// Latest state posted by the handlers, read by the render task. Each field is
+// written as a single word, and pending_state is raised once they are all written.
+static std::atomic<uint32_t> desired_color(0);
+static std::atomic<uint8_t> desired_brightness(255);
+static std::atomic<bool> desired_on(false);
+static std::atomic<bool> pending_state(false);
+// Raised before pending_state by the color and switch updates, which replace a posted
+// frame by the solid color. A brightness update applies to the frame shown.
+static std::atomic<bool> pending_color(false);
+
+// Posted state updates, and those overwritten before the render task read them.
+static std::atomic<uint32_t> posted_commands(0);
+static std::atomic<uint32_t> coalesced_commands(0);
+
+// Frames posted by post_frame, triple buffered: the poster fills frame_back, the
+// render task shows frame_front, and they exchange them with frame_middle, which is
+// flagged with FRAME_FRESH until the render task takes it.
+#define FRAME_FRESH 0x80
+static uint8_t* frame_buffers[3] = { };
+static uint16_t frame_pixels[3];
+static size_t frame_size = 0;
+static uint8_t frame_back = 0;
+static uint8_t frame_front = 1;
+static std::atomic<uint8_t> frame_middle(2);
+// Held by the task filling frame_back.
+static SemaphoreHandle_t frame_poster = NULL;
+
+/**
+ * Packs a color in a word, as 0xWWBBGGRR.
+ */
+static uint32_t pack_color(pixel_t color) {
+  return color.red | (color.green << 8) | (color.blue << 16) | ((uint32_t) color.white << 24);
+}
+
+static pixel_t unpack_color(uint32_t color) {
+  pixel_t pixel;
+  pixel.red = color & 0xff;
+  pixel.green = (color >> 8) & 0xff;
+  pixel.blue = (color >> 16) & 0xff;
+  pixel.white = color >> 24;
+  return pixel;
+}
+
+/**
+ * Interpolates between two colors.
+ * @param[in] from Color at weight 0
+ * @param[in] to Color at weight 256
+ * @param[in] weight Progress from 0 to 256
+ * @return The interpolated color
+ */
+static pixel_t lerp_color(pixel_t from, pixel_t to, uint32_t weight) {
+  pixel_t color;
+  color.red = (from.red * (256 - weight) + to.red * weight) >> 8;
+  color.green = (from.green * (256 - weight) + to.green * weight) >> 8;
+  color.blue = (from.blue * (256 - weight) + to.blue * weight) >> 8;
+  color.white = (from.white * (256 - weight) + to.white * weight) >> 8;
+  return color;
+}
+
+/**
+ * Owns the strip once started. Wakes at a fixed rate, picks up the latest posted
+ * state and fades the strip from the frame shown when it arrived to the target
+ * color over CONFIG_STRIP_FADE_TIME ms. A posted frame is shown until the color or
+ * the switch changes, brightness changes applying to it. Frames are only sent while
+ * fading, or on every period when dithering. Periods missed because a frame took too long are
+ * counted as dropped frames rather than caught up.
+ */
+static void strip_render_task(void* arg) {
+  // Rates above the tick rate round down to no tick at all, they run at the tick rate.
+  TickType_t period = pdMS_TO_TICKS(1000 / CONFIG_STRIP_RENDER_FPS);
+  if (period == 0) {
+    period = 1;
+  }
+  const int64_t fade_us = CONFIG_STRIP_FADE_TIME * 1000LL;
+  // A strip not configured yet has no pixel to start from.
+  pixel_t current = num_led > 0 ? strip->getPixel(0) : pixel_t { };
+  pixel_t from = current;
+  pixel_t to = current;
+  int64_t fade_start = 0;
+  bool fading = false;
+  // Whether the strip shows the solid color to, rather than a posted frame.
+  bool solid = true;
+  TickType_t last_wake = xTaskGetTickCount();
+  while (true) {
+#if CONFIG_STRIP_DITHERING
+    bool dirty = true;
+#else
+    bool dirty = false;
+#endif
+    if (pending_state.exchange(false, std::memory_order_acquire)) {
+      uint8_t brightness = desired_brightness.load(std::memory_order_relaxed);
+      if (brightness != strip->getBrightness()) {
+        strip->setBrightness(brightness);
+        dirty = true;
+      }
+      bool leave_frame = pending_color.exchange(false, std::memory_order_acquire);
+      pixel_t color = desired_on.load(std::memory_order_relaxed)
+        ? unpack_color(desired_color.load(std::memory_order_relaxed)) : pixel_t { };
+      if (solid ? pack_color(color) != pack_color(to) : leave_frame) {
+        // A frame is not faded from, the color is set at once.
+        from = solid ? current : color;
+        to = color;
+        fade_start = esp_timer_get_time();
+        fading = true;
+        solid = true;
+      }
+    }
+    if (frame_middle.load(std::memory_order_relaxed) & FRAME_FRESH) {
+      frame_front = frame_middle.exchange(frame_front, std::memory_order_acquire) & ~FRAME_FRESH;
+      if (desired_on.load(std::memory_order_relaxed)) {
+        strip->copyWireFrom(frame_buffers[frame_front], frame_pixels[frame_front]);
+        fading = false;
+        solid = false;
+        dirty = true;
+      }
+    }
+    if (fading) {
+      int64_t elapsed = esp_timer_get_time() - fade_start;
+      uint32_t weight = elapsed >= fade_us ? 256 : (uint32_t) ((elapsed << 8) / fade_us);
+      current = lerp_color(from, to, weight);
+      strip->fill(current);
+      fading = weight < 256;
+      dirty = true;
+    }
+    if (dirty) {
+      strip->showAsync();
+    }
+    TickType_t late = xTaskGetTickCount() - last_wake;
+    if (late >= period) {
+      dropped_frames += late / period;
+      last_wake += late / period * period;
+    }
+    vTaskDelayUntil(&last_wake, period);
+  }
+}
+
+/**
+ * Tells the render task that the desired state changed. Does not block: when the
+ * previous update has not been rendered yet, it is replaced by this one.
+ * @param[in] color Whether the color or the switch changed, rather than only the
+ * brightness
+ */
+static void post_state(bool color) {
+  posted_commands.fetch_add(1, std::memory_order_relaxed);
+  if (color) {
+    pending_color.store(true, std::memory_order_release);
+  }
+  if (pending_state.exchange(true, std::memory_order_release)) {
+    coalesced_commands.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+/**
+ * Takes the buffer in which the next frame can be written, before posting it with
+ * post_frame or giving it up with release_frame_buffer. The poster can fill it piece
+ * by piece, as the frame is received. Only one poster holds the buffer at a time,
+ * the others are turned away rather than blocked.
+ * @param[out] size Size of the buffer, 0 when it cannot be taken
+ * @return The buffer of the next frame, or NULL when frames are disabled or the
+ * buffer is held by another poster
+ */
+uint8_t* acquire_frame_buffer(size_t* size) {
+  if (frame_size == 0 || xSemaphoreTake(frame_poster, 0) != pdTRUE) {
+    *size = 0;
+    return NULL;
+  }
+  *size = frame_size;
+  return frame_buffers[frame_back];
+}
+
+/**
+ * Gives up the frame buffer taken with acquire_frame_buffer without posting it.
+ */
+void release_frame_buffer() {
+  xSemaphoreGive(frame_poster);
+}
+
+/**
+ * Posts the frame written in the buffer taken with acquire_frame_buffer to the
+ * render task, and releases the buffer. The frame is shown as is, without fading,
+ * and dropped while the strip is switched off. When the previous frame has not
+ * been rendered yet, it is replaced by this one.
+ * @param[in] length Length of the frame, in bytes
+ */
+void post_frame(size_t length) {
+  frame_pixels[frame_back] = length / strip->getChannelCount();
+  posted_commands.fetch_add(1, std::memory_order_relaxed);
+  uint8_t previous = frame_middle.exchange(frame_back | FRAME_FRESH, std::memory_order_acq_rel);
+  if (previous & FRAME_FRESH) {
+    coalesced_commands.fetch_add(1, std::memory_order_relaxed);
+  }
+  frame_back = previous & ~FRAME_FRESH;
+  xSemaphoreGive(frame_poster);
+}
+
+/**
+ * Starts the render task on the application core, leaving the protocol core to
+ * WiFi and the network handlers.
+ */
+void start_strip_render() {
+  xTaskCreatePinnedToCore(strip_render_task, "strip render", STRIP_RENDER_STACK_SIZE, NULL, 10, &render_task, APP_CPU_NUM);
+}
+
+uint32_t get_dropped_frames() {
+  return dropped_frames;
+}
+
+uint32_t get_posted_commands() {
+  return posted_commands.load(std::memory_order_relaxed);
+}
+
+uint32_t get_coalesced_commands() {
+  return coalesced_commands.load(std::memory_order_relaxed);
+}
+
+void reset_strip_stats() {
+  strip->resetStats();
+  dropped_frames = 0;
+  posted_commands = 0;
+  coalesced_commands = 0;
+}
+
+/**
+ * Writes the strip frame timings, the pixels encoded and the power limiter state as a
+ * JSON object, for telemetry.
+ * @param[out] buffer Buffer receiving the JSON object
+ * @param[in] size Size of the buffer
+ * @return The length of the JSON object, as returned by snprintf
+ */
+int format_strip_stats(char* buffer, size_t size) {
+  ws2812_stats_t stats;
+  strip->getStats(&stats);
+  int length = snprintf(buffer, size,
+    "{\"frames\":%u,\"dropped\":%u,\"stalled\":%u,\"commands\":%u,\"coalesced\":%u,"
+    "\"encode_us\":%u,\"encode_max_us\":%u,\"transmit_us\":%u,\"transmit_max_us\":%u,"
+    "\"interval_us\":%u,\"interval_max_us\":%u,\"encoded\":%u,\"total_encoded\":%u,"
+    "\"power_scale\":%u,\"estimated_ma\":%u,\"render_stack_free\":%u,\"encode_histogram\":[",
+    stats.frames, dropped_frames, stats.stalledFrames, get_posted_commands(), get_coalesced_commands(),
+    stats.lastEncodeUs, stats.maxEncodeUs, stats.lastTransmitUs, stats.maxTransmitUs,
+    stats.lastIntervalUs, stats.maxIntervalUs, strip->getEncodedPixelCount(), strip->getTotalEncodedPixelCount(),
+    strip->getPowerScale(), strip->getEstimatedCurrent(),
+    render_task != NULL ? (unsigned) uxTaskGetStackHighWaterMark(render_task) : 0);
+  for (int i = 0; i < WS2812_STATS_BUCKETS && length < (int) size; i++) {
+    length += snprintf(buffer + length, size - length, i == 0 ? "%u" : ",%u", stats.encodeHistogram[i]);
+  }
+  if (length < (int) size) {
+    length += snprintf(buffer + length, size - length, "]}");
+  }
+  return length;
+}
+
 void init_strip() {
   if (!load_led_number_from_nvs(&num_led)) {
     // No led number has been specified yet
     num_led = 0;
   }
   ESP_LOGI(MODULE_TAG, "Led number : %i", num_led);
-  static WS2812 _strip = WS2812((gpio_num_t) LED_PIN, num_led, RMT_CHANNEL_0);
+  ws2812_type_t type;
+  if (!load_strip_type_from_nvs(&type)) {
+    type = WS2812_TYPE_WS2812;
+  }
+  ESP_LOGI(MODULE_TAG, "Strip type : %s", strip_type_name(type));
+#if CONFIG_STRIP_BUFFERS_IN_PSRAM
+  ws2812_placement_t placement = WS2812_PLACEMENT_SPIRAM;
+#else
+  ws2812_placement_t placement = WS2812_PLACEMENT_INTERNAL;
+#endif
+#if CONFIG_STRIP_OUTPUT_SPI
+  static WS2812 _strip = WS2812((gpio_num_t) LED_PIN, num_led, HSPI_HOST, WS2812_OUTPUT_SPI, 0, type, placement);
+#elif CONFIG_STRIP_OUTPUT_RMT_STREAM
+  static WS2812 _strip = WS2812((gpio_num_t) LED_PIN, num_led, RMT_CHANNEL_0, WS2812_OUTPUT_RMT_STREAM, 0, type, placement);
+#else
+  static WS2812 _strip = WS2812((gpio_num_t) LED_PIN, num_led, RMT_CHANNEL_0, WS2812_OUTPUT_RMT, 0, type, placement);
+#endif
   strip = &_strip;
+  strip->setGamma(CONFIG_STRIP_GAMMA / 10.0f);
+  strip->setPowerLimit(CONFIG_STRIP_POWER_LIMIT);
+#if CONFIG_STRIP_DITHERING
+  strip->setDithering(true);
+#endif
+#if CONFIG_MQTT_BINARY_PAYLOADS || CONFIG_E131_RECEIVER || CONFIG_ARTNET_NODE
+  frame_size = num_led * strip->getChannelCount();
+#endif
+  for (int i = 0; i < 3 && frame_size > 0; i++) {
+    frame_buffers[i] = (uint8_t*) malloc(frame_size);
+    if (frame_buffers[i] == NULL) {
+      ESP_LOGE(MODULE_TAG, "Not enough memory for the frame buffers, frames are ignored");
+      for (int j = 0; j < i; j++) {
+        free(frame_buffers[j]);
+      }
+      frame_size = 0;
+    }
+  }
+  frame_poster = xSemaphoreCreateMutex();
 }
 void save_led_number_to_nvs(uint16_t led_number) {
   // Init NVS connection
@@ -42,41 +347,100 @@ bool load_led_number_from_nvs(uint16_t* led_number) {
   return found;
 }
 
+void save_strip_type_to_nvs(ws2812_type_t type) {
+  // Init NVS connection
+  nvs_handle nvs_config_handle;
+  ESP_ERROR_CHECK(nvs_open("conf", NVS_READWRITE, &nvs_config_handle));
+
+  // Save type
+  ESP_LOGI(MODULE_TAG, "Save strip type to nvs : %s", strip_type_name(type));
+  ESP_ERROR_CHECK(nvs_set_u8(nvs_config_handle, "strip_type", type));
+  ESP_ERROR_CHECK(nvs_commit(nvs_config_handle));
+
+  // Close NVS handler
+  nvs_close(nvs_config_handle);
+}
+
+bool load_strip_type_from_nvs(ws2812_type_t* type) {
+  // Init nvs connection
+  nvs_handle nvs_config_handle;
+  ESP_ERROR_CHECK(nvs_open("conf", NVS_READONLY, &nvs_config_handle));
+
+  // Load type
+  uint8_t value;
+  esp_err_t err = nvs_get_u8(nvs_config_handle, "strip_type", &value);
+  bool found = false;
+  if (err == ESP_OK && value <= WS2812_TYPE_SK6812_RGBW) {
+    found = true;
+    *type = (ws2812_type_t) value;
+  }
+
+  nvs_close(nvs_config_handle);
+  return found;
+}
+
 /**
- * Called on color received. Convert the string payload into a 4 bytes long that
- * and send it to the strip.
- * @param[in] payload_length Length of the MQTT message payload
- * @param[in] payload MQTT message payload
+ * Finds the strip type of the given name, such as "ws2812" or "sk6812_rgbw".
+ * @param[in] name Name of the strip type
+ * @param[out] type Corresponding strip type
+ * @return false if the name is unknown
  */
-void handle_color_changed(long color) {
-    uint32_t int_color = color  & 0xffffffff;
-    last_color.red = (int_color >> 16) & 0xff;
-    last_color.green = (int_color >> 8) & 0xff;
-    last_color.blue = int_color & 0xff;
-    ESP_LOGI(MODULE_TAG, "Set color : %i, %i, %i", last_color.red, last_color.green, last_color.blue);
-    if (on) {
-      for (int i = 0; i < num_led; i++) {
-        strip->setPixel(i, last_color);
-      }
-      strip->show();
+bool parse_strip_type(const char* name, ws2812_type_t* type) {
+  for (int i = 0; i <= WS2812_TYPE_SK6812_RGBW; i++) {
+    if (strcmp(name, strip_type_names[i]) == 0) {
+      *type = (ws2812_type_t) i;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char* strip_type_name(ws2812_type_t type) {
+  return strip_type_names[type];
+}
+
+/**
+ * Called on color received. Sends the 0xRRGGBB color to the strip.
+ * @param[in] color Color received. The upper byte is ignored, it is the alpha of
+ * the ARGB colors of the server.
+ * @param[in] white White level of RGBW strips, only set by the payloads that carry it
+ */
+void handle_color_changed(uint32_t color, uint8_t white) {
+    pixel_t last_color;
+    last_color.red = (color >> 16) & 0xff;
+    last_color.green = (color >> 8) & 0xff;
+    last_color.blue = color & 0xff;
+    last_color.white = white;
+    ESP_LOGI(MODULE_TAG, "Set color : %i, %i, %i, %i", last_color.red, last_color.green, last_color.blue, last_color.white);
+    desired_color.store(pack_color(last_color), std::memory_order_relaxed);
+    post_state(true);
+}
+
+/**
+ * Called on brightness received. Only the strip master brightness changes, the
+ * color of the pixels is kept.
+ * @param[in] brightness New brightness, from 0 to 255
+ */
+void handle_brightness_changed(long brightness) {
+    if (brightness < 0) {
+      brightness = 0;
+    } else if (brightness > 255) {
+      brightness = 255;
     }
+    ESP_LOGI(MODULE_TAG, "Set brightness : %li", brightness);
+    desired_brightness.store(brightness, std::memory_order_relaxed);
+    post_state(false);
 }
 
 void handle_switch(const char* switch_str) {
     if (strcmp(switch_str, "ON") == 0) {
       ESP_LOGI(MODULE_TAG, "Switch On");
-      on = true;
-      for (int i = 0; i < num_led; i++) {
-        strip->setPixel(i, last_color);
-      }
-      strip->show();
+      desired_on.store(true, std::memory_order_relaxed);
+      post_state(true);
     }
     else {
       ESP_LOGI(MODULE_TAG, "Switch Off");
-      on = false;
-      for (int i = 0; i < num_led; i++) {
-        strip->setPixel(i, 0, 0, 0);
-      }
-      strip->show();
+      desired_on.store(false, std::memory_order_relaxed);
+      post_state(true);
     }
 }
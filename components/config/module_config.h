@@ -3,13 +3,25 @@
 
 #define MODULE_TAG "MODULE"
 
-static pixel_t last_color = { };
-static bool on;
 extern WS2812* strip;
 extern uint16_t num_led;
 
 void init_strip();
+void start_strip_render();
+uint32_t get_dropped_frames();
+uint32_t get_posted_commands();
+uint32_t get_coalesced_commands();
+void reset_strip_stats();
+int format_strip_stats(char* buffer, size_t size);
 void save_led_number_to_nvs(uint16_t led_number);
 bool load_led_number_from_nvs(uint16_t* led_number);
-void handle_color_changed(long color);
+void save_strip_type_to_nvs(ws2812_type_t type);
+bool load_strip_type_from_nvs(ws2812_type_t* type);
+bool parse_strip_type(const char* name, ws2812_type_t* type);
+const char* strip_type_name(ws2812_type_t type);
+void handle_color_changed(uint32_t color, uint8_t white);
+void handle_brightness_changed(long brightness);
 void handle_switch(const char* switch_str);
+uint8_t* acquire_frame_buffer(size_t* size);
+void release_frame_buffer();
+void post_frame(size_t length);
@@ -3,6 +3,28 @@
 
 static esp_mqtt_client_handle_t client;
 static bool client_initialized = false;
+static TaskHandle_t telemetry_task_handle = NULL;
+
+/**
+ * Periodically publishes the strip frame timings and the MQTT reassembly counters
+ * on the telemetry topic.
+ */
+static void telemetry_task(void* arg) {
+  char payload[768];
+  while (true) {
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_MQTT_TELEMETRY_PERIOD * 1000));
+    int length = format_strip_stats(payload, sizeof(payload));
+    if (length > 0 && length < (int) sizeof(payload)) {
+      // Add the reassembly counters to the strip stats object.
+      mqtt_reassembly_stats_t stats;
+      get_mqtt_reassembly_stats(&stats);
+      snprintf(payload + length - 1, sizeof(payload) - length + 1,
+        ",\"mqtt\":{\"messages\":%u,\"fragmented\":%u,\"oversized\":%u,\"busy\":%u,\"incomplete\":%u}}",
+        stats.messages, stats.fragmented, stats.oversized, stats.busy, stats.incomplete);
+    }
+    esp_mqtt_client_publish(client, telemetry_topic, payload, 0, 0, 0);
+  }
+}
 
 void save_mqtt_uri_to_nvs(const char* uri) {
   // Init NVS connection
@@ -83,6 +105,194 @@ esp_err_t test_mqtt_event_handler(esp_mqtt_event_handle_t event)
   return ESP_OK;
 }
 
+// Message being reassembled from the fragments of MQTT_EVENT_DATA events. Its
+// payload is written straight to its destination: the next frame buffer for
+// frames, short_payload for the other messages.
+static struct {
+  mqtt_message_t type;
+  uint8_t* destination;
+  size_t length;
+  size_t received;
+} message = { };
+static char short_payload[MQTT_SHORT_PAYLOAD_SIZE + 1];
+static mqtt_reassembly_stats_t reassembly_stats = { };
+
+static bool is_topic(esp_mqtt_event_handle_t event, const char* topic) {
+  return event->topic_len == (int) strlen(topic) && memcmp(event->topic, topic, event->topic_len) == 0;
+}
+
+#define STATE_TOPIC_KEY(length, first) ((length) << 8 | (first))
+
+/**
+ * Finds the type of a message from the suffix of its /devices/<id>/state/ topic. The
+ * suffixes are told apart by their length and first character, then compared once,
+ * so that the dispatch cost does not grow with the number of topics.
+ */
+static mqtt_message_t get_state_message_type(const char* suffix, int length) {
+  const char* name;
+  mqtt_message_t type;
+  switch (STATE_TOPIC_KEY(length, suffix[0])) {
+    case STATE_TOPIC_KEY(6, 's'):
+      name = "switch";
+      type = MQTT_MESSAGE_SWITCH;
+      break;
+    case STATE_TOPIC_KEY(5, 'c'):
+      name = "color";
+      type = MQTT_MESSAGE_COLOR;
+      break;
+    case STATE_TOPIC_KEY(10, 'b'):
+      name = "brightness";
+      type = MQTT_MESSAGE_BRIGHTNESS;
+      break;
+#if CONFIG_MQTT_BINARY_PAYLOADS
+    case STATE_TOPIC_KEY(5, 'f'):
+      name = "frame";
+      type = MQTT_MESSAGE_FRAME;
+      break;
+#endif
+    default:
+      return MQTT_MESSAGE_NONE;
+  }
+  return memcmp(suffix, name, length) == 0 ? type : MQTT_MESSAGE_NONE;
+}
+
+/**
+ * Finds the type of a message from the topic of its first fragment.
+ */
+static mqtt_message_t get_message_type(esp_mqtt_event_handle_t event) {
+  if (event->topic_len > state_topic_prefix_length
+      && memcmp(event->topic, state_topic_prefix, state_topic_prefix_length) == 0) {
+    return get_state_message_type(event->topic + state_topic_prefix_length, event->topic_len - state_topic_prefix_length);
+  } else if (is_topic(event, check_topic)) {
+    return MQTT_MESSAGE_CHECK;
+  }
+  return MQTT_MESSAGE_NONE;
+}
+
+/**
+ * Handles the message once all its fragments have been received.
+ */
+static void dispatch_message(esp_mqtt_client_handle_t client) {
+  if (message.destination == (uint8_t*) short_payload) {
+    short_payload[message.length] = '\0';
+  }
+  switch (message.type) {
+    case MQTT_MESSAGE_CHECK:
+      esp_mqtt_client_publish(client, connection_topic, device_id, 0, 1, 0);
+      break;
+
+    case MQTT_MESSAGE_SWITCH:
+      handle_switch(short_payload);
+      break;
+
+    case MQTT_MESSAGE_COLOR:
+#if CONFIG_MQTT_BINARY_PAYLOADS
+      // Red, green and blue bytes, followed by the white one on RGBW strips.
+      if (message.length == 3 || message.length == 4) {
+        const uint8_t* data = message.destination;
+        uint32_t color = data[0] << 16 | data[1] << 8 | data[2];
+        handle_color_changed(color, message.length == 4 ? data[3] : 0);
+      } else {
+        ESP_LOGW(MQTT_TAG, "Ignoring a color of %i bytes", message.length);
+      }
+#else
+      // ARGB colors with an alpha of 128 or more do not fit in a long. The alpha
+      // is not a white level, only binary colors set the white channel.
+      handle_color_changed(strtoul(short_payload, NULL, 10), 0);
+#endif
+      break;
+
+    case MQTT_MESSAGE_BRIGHTNESS:
+      handle_brightness_changed(strtol(short_payload, NULL, 10));
+      break;
+
+    case MQTT_MESSAGE_FRAME:
+      post_frame(message.length);
+      break;
+
+    case MQTT_MESSAGE_NONE:
+      break;
+  }
+}
+
+/**
+ * Drops the message being reassembled, giving up its frame buffer.
+ */
+static void drop_message() {
+  if (message.type == MQTT_MESSAGE_FRAME) {
+    release_frame_buffer();
+  }
+  message.type = MQTT_MESSAGE_NONE;
+}
+
+/**
+ * Copies the fragment of a message to its destination, and handles the message
+ * when it is complete. Messages larger than their destination are rejected, as
+ * well as messages whose fragments do not follow each other.
+ */
+static void receive_fragment(esp_mqtt_client_handle_t client, esp_mqtt_event_handle_t event) {
+  if (event->current_data_offset == 0) {
+    if (message.type != MQTT_MESSAGE_NONE) {
+      reassembly_stats.incomplete++;
+      drop_message();
+    }
+    mqtt_message_t type = get_message_type(event);
+    if (type == MQTT_MESSAGE_NONE) {
+      return;
+    }
+    reassembly_stats.messages++;
+    if (event->data_len < event->total_data_len) {
+      reassembly_stats.fragmented++;
+    }
+    size_t capacity = MQTT_SHORT_PAYLOAD_SIZE;
+    uint8_t* destination = (uint8_t*) short_payload;
+    if (type == MQTT_MESSAGE_FRAME) {
+      destination = acquire_frame_buffer(&capacity);
+      if (destination == NULL) {
+        // Frames are disabled, or another source such as E1.31 is writing one.
+        ESP_LOGW(MQTT_TAG, "Rejecting a frame, the frame buffer is not available");
+        reassembly_stats.busy++;
+        return;
+      }
+    }
+    if ((size_t) event->total_data_len > capacity) {
+      ESP_LOGW(MQTT_TAG, "Rejecting a message of %i bytes on %.*s", event->total_data_len, event->topic_len, event->topic);
+      reassembly_stats.oversized++;
+      if (type == MQTT_MESSAGE_FRAME) {
+        release_frame_buffer();
+      }
+      return;
+    }
+    message.type = type;
+    message.destination = destination;
+    message.length = event->total_data_len;
+    message.received = 0;
+  } else if (message.type == MQTT_MESSAGE_NONE) {
+    // Rest of a rejected or ignored message.
+    return;
+  }
+  if (event->current_data_offset != (int) message.received || message.received + event->data_len > message.length) {
+    ESP_LOGW(MQTT_TAG, "Dropping a message with missing fragments");
+    reassembly_stats.incomplete++;
+    drop_message();
+    return;
+  }
+  memcpy(message.destination + message.received, event->data, event->data_len);
+  message.received += event->data_len;
+  if (message.received == message.length) {
+    dispatch_message(client);
+    message.type = MQTT_MESSAGE_NONE;
+  }
+}
+
+void get_mqtt_reassembly_stats(mqtt_reassembly_stats_t* stats) {
+  *stats = reassembly_stats;
+}
+
+void reset_mqtt_reassembly_stats() {
+  reassembly_stats = { };
+}
+
 esp_err_t main_mqtt_event_handler(esp_mqtt_event_handle_t event)
 {
   esp_mqtt_client_handle_t client = event->client;
@@ -97,15 +307,18 @@ esp_err_t main_mqtt_event_handler(esp_mqtt_event_handle_t event)
           // Publish device_id to /connected topic
           esp_mqtt_client_publish(client, connection_topic, device_id, 0, 1, 0);
 
-          // Firstly, connect to switch topic, and wait for the first switch initialization message.
+          // Subscribe to all the state topics at once, and wait for the first switch initialization message.
           // -> go to MQTT_EVENT_DATA
           ESP_LOGI(MQTT_TAG, "Subscribing to topics...");
-          printf("%s\n", switch_topic);
-          printf("%s\n", color_topic);
+          printf("%s\n", state_topics);
           printf("%s\n", check_topic);
-          esp_mqtt_client_subscribe(client, switch_topic, 1);
-          esp_mqtt_client_subscribe(client, color_topic, 1);
+          esp_mqtt_client_subscribe(client, state_topics, 1);
           esp_mqtt_client_subscribe(client, check_topic, 1);
+#if CONFIG_MQTT_TELEMETRY_PERIOD > 0
+          if (telemetry_task_handle == NULL) {
+            xTaskCreate(telemetry_task, "mqtt telemetry", 3072, NULL, 5, &telemetry_task_handle);
+          }
+#endif
           break;
       case MQTT_EVENT_BEFORE_CONNECT:
           break;
@@ -134,40 +347,8 @@ esp_err_t main_mqtt_event_handler(esp_mqtt_event_handle_t event)
       case MQTT_EVENT_DATA:
           ESP_LOGI(MQTT_TAG, "MQTT_EVENT_DATA");
           printf("TOPIC=%.*s\r\n", event->topic_len, event->topic);
-          printf("DATA=%.*s\r\n", event->data_len, event->data);
-          size_t topic_len = event->topic_len;
-          char topic_str[topic_len + 1];
-          for (int i = 0; i < topic_len + 1; i++) {
-            topic_str[i] = event->topic[i];
-          }
-          topic_str[topic_len] = '\0';
-
-          if (strcmp(topic_str, check_topic) == 0) {
-            esp_mqtt_client_publish(client, connection_topic, device_id, 0, 1, 0);
-          }
-
-
-          else if (strcmp(topic_str, switch_topic) == 0) {
-            char switch_str[event->data_len + 1];
-            for (int i = 0; i < event->data_len + 1; i++) {
-              switch_str[i] = event->data[i];
-            }
-            switch_str[event->data_len] = '\0';
-            handle_switch(switch_str);
-          }
-
-          else if (strcmp(topic_str, color_topic) == 0) {
-            char color_str[event->data_len + 1];
-            for (int i = 0; i < event->data_len + 1; i++) {
-              color_str[i] = event->data[i];
-            }
-            color_str[event->data_len] = '\0';
-            char* ptr;
-            long color = strtol(color_str, &ptr, 10);
-
-            handle_color_changed(color);
-          }
-
+          printf("DATA=%i/%i bytes at %i\r\n", event->data_len, event->total_data_len, event->current_data_offset);
+          receive_fragment(client, event);
           break;
 
   }
@@ -182,8 +363,9 @@ void mqtt_app_start(const char* broker_uri, mqtt_event_callback_t mqtt_event_han
   load_id_from_nvs(&id);
   sprintf(device_id, "%i", id);
   sprintf(client_id, "light_%i", id);
-  sprintf(color_topic, "/devices/%i/state/color", id);
-  sprintf(switch_topic, "/devices/%i/state/switch", id);
+  state_topic_prefix_length = sprintf(state_topic_prefix, "/devices/%i/state/", id);
+  sprintf(state_topics, "/devices/%i/state/#", id);
+  sprintf(telemetry_topic, "/devices/%i/telemetry", id);
 
   ESP_LOGI(MQTT_TAG, "Connecting to broker... (%s)", broker_uri);
 
@@ -213,6 +395,10 @@ void mqtt_app_start(const char* broker_uri, mqtt_event_callback_t mqtt_event_han
 }
 
 void clean_mqtt() {
+  if (telemetry_task_handle != NULL) {
+    vTaskDelete(telemetry_task_handle);
+    telemetry_task_handle = NULL;
+  }
   if (client_initialized) {
     ESP_ERROR_CHECK( esp_mqtt_client_destroy(client) );
     client_initialized = false;
@@ -16,13 +16,38 @@
 
 static char device_id[5];
 static char client_id[10];
-static char color_topic[50];
-static char switch_topic[50];
+// Prefix of the topics of the state of the device, such as /devices/<id>/state/color
+static char state_topic_prefix[50];
+static int state_topic_prefix_length;
+// Subscription to all the state topics
+static char state_topics[50];
+static char telemetry_topic[50];
 static char const *connection_topic = "/connected";
 static char const *disconnection_topic = "/disconnected";
 static char const *check_topic = "/check";
 
 
+// Longest payload of the messages other than frames.
+#define MQTT_SHORT_PAYLOAD_SIZE 32
+
+typedef enum {
+  MQTT_MESSAGE_NONE,
+  MQTT_MESSAGE_CHECK,
+  MQTT_MESSAGE_SWITCH,
+  MQTT_MESSAGE_COLOR,
+  MQTT_MESSAGE_BRIGHTNESS,
+  MQTT_MESSAGE_FRAME
+} mqtt_message_t;
+
+// Counters of the reassembly of the messages split over several MQTT_EVENT_DATA.
+typedef struct {
+  uint32_t messages;   // Messages received on the subscribed topics
+  uint32_t fragmented; // Messages split over several events
+  uint32_t oversized;  // Messages rejected because larger than their destination
+  uint32_t busy;       // Frames rejected because the frame buffer is disabled or held by another source
+  uint32_t incomplete; // Messages dropped because of missing fragments
+} mqtt_reassembly_stats_t;
+
 struct mqtt_context {
   volatile int connected;
 };
@@ -34,3 +59,5 @@ void save_mqtt_uri_to_nvs(const char* uri);
 bool load_mqtt_uri_from_nvs(char** uri);
 void mqtt_app_start(const char* uri, mqtt_event_callback_t mqtt_event_handler);
 void clean_mqtt();
+void get_mqtt_reassembly_stats(mqtt_reassembly_stats_t* stats);
+void reset_mqtt_reassembly_stats();
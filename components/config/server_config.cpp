@@ -89,7 +89,7 @@ esp_err_t fetch_device_handler(esp_http_client_event_t *evt)
   cJSON *state;
   cJSON *color_object;
   char* status;
-  long color;
+  uint32_t color;
   switch(evt->event_id) {
       case HTTP_EVENT_ERROR:
           ESP_LOGI(SERVER_TAG, "HTTP ERROR");
@@ -108,10 +108,10 @@ esp_err_t fetch_device_handler(esp_http_client_event_t *evt)
           state = cJSON_GetObjectItem(device, "state");
           status = cJSON_GetObjectItem(state, "toggle")->valuestring;
           color_object = cJSON_GetObjectItem(state, "color");
-          color = (long) cJSON_GetObjectItem(color_object, "argb")->valuedouble;
+          color = (uint32_t) cJSON_GetObjectItem(color_object, "argb")->valuedouble;
 
           handle_switch(status);
-          handle_color_changed(color);
+          handle_color_changed(color, 0);
           cJSON_Delete(device);
           break;
       case HTTP_EVENT_ON_FINISH:
@@ -130,7 +130,7 @@ esp_err_t create_device_handler(esp_http_client_event_t *evt)
   cJSON *state;
   cJSON *color_object;
   char* status;
-  long color;
+  uint32_t color;
   int32_t device_id;
   switch(evt->event_id) {
       case HTTP_EVENT_ERROR:
@@ -150,13 +150,13 @@ esp_err_t create_device_handler(esp_http_client_event_t *evt)
           state = cJSON_GetObjectItem(device, "state");
           status = cJSON_GetObjectItem(state, "toggle")->valuestring;
           color_object = cJSON_GetObjectItem(state, "color");
-          color = (long) cJSON_GetObjectItem(color_object, "argb")->valuedouble;
+          color = (uint32_t) cJSON_GetObjectItem(color_object, "argb")->valuedouble;
 
           ESP_LOGI(SERVER_TAG, "device id : %i", device_id);
           save_id_to_nvs(device_id);
 
           handle_switch(status);
-          handle_color_changed(color);
+          handle_color_changed(color, 0);
           cJSON_Delete(device);
           device_registered = true;
           break;
@@ -0,0 +1,61 @@
+#ifndef MAIN_BITTRANSPOSE_H_
+#define MAIN_BITTRANSPOSE_H_
+#include <stdint.h>
+
+/*
+ * Bit matrix transposition kernels used to drive several strips in parallel.
+ *
+ * Parallel outputs need the data as bit planes: one word per bit position, each word holding
+ * that bit for every strip.  These kernels turn one byte per strip into such planes with a few
+ * shift and mask operations per 8 bytes, instead of 64 single bit moves.  They only depend on
+ * <stdint.h> so they can be built and checked on any host.
+ */
+
+/**
+ * @brief Transpose 8 bytes into 8 bit planes.
+ *
+ * On return, bit s of planes[k] is bit 7 - k of bytes[s]: planes[0] gathers the most significant
+ * bit of every byte, bytes[0] being on bit 0.
+ *
+ * @param [in] bytes The 8 bytes to transpose, one per strip.
+ * @param [out] planes The 8 bit planes, most significant bit first.
+ */
+static inline void transpose8x8(const uint8_t* bytes, uint8_t* planes) {
+	// Rows are loaded in reverse so that bytes[s] ends up on bit s of each plane.
+	uint32_t x = ((uint32_t) bytes[7] << 24) | ((uint32_t) bytes[6] << 16) | ((uint32_t) bytes[5] << 8) | bytes[4];
+	uint32_t y = ((uint32_t) bytes[3] << 24) | ((uint32_t) bytes[2] << 16) | ((uint32_t) bytes[1] << 8) | bytes[0];
+	uint32_t t;
+
+	// Swap 1x1, then 2x2 blocks within each 4x4 half, then the 4x4 blocks between the halves.
+	t = (x ^ (x >> 7)) & 0x00AA00AA;  x = x ^ t ^ (t << 7);
+	t = (y ^ (y >> 7)) & 0x00AA00AA;  y = y ^ t ^ (t << 7);
+	t = (x ^ (x >> 14)) & 0x0000CCCC; x = x ^ t ^ (t << 14);
+	t = (y ^ (y >> 14)) & 0x0000CCCC; y = y ^ t ^ (t << 14);
+	t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+	y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+	x = t;
+
+	planes[0] = x >> 24; planes[1] = x >> 16; planes[2] = x >> 8; planes[3] = x;
+	planes[4] = y >> 24; planes[5] = y >> 16; planes[6] = y >> 8; planes[7] = y;
+} // transpose8x8
+
+
+/**
+ * @brief Transpose 16 bytes into 8 16 bits wide bit planes.
+ *
+ * On return, bit s of planes[k] is bit 7 - k of bytes[s].
+ *
+ * @param [in] bytes The 16 bytes to transpose, one per strip.
+ * @param [out] planes The 8 bit planes, most significant bit first.
+ */
+static inline void transpose16x8(const uint8_t* bytes, uint16_t* planes) {
+	uint8_t low[8];
+	uint8_t high[8];
+	transpose8x8(bytes, low);
+	transpose8x8(bytes + 8, high);
+	for (uint8_t k = 0; k < 8; k++) {
+		planes[k] = ((uint16_t) high[k] << 8) | low[k];
+	}
+} // transpose16x8
+
+#endif /* MAIN_BITTRANSPOSE_H_ */
@@ -1,9 +1,16 @@
 #include <esp_log.h>
 #include <driver/rmt.h>
 #include <driver/gpio.h>
+#include <driver/spi_master.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <soc/soc.h>
+#include <soc/soc_memory_layout.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
+#include <math.h>
 #include <stdexcept>
 
 #include "GPIO.h"
@@ -17,6 +24,13 @@
 
 static const char* LOG_TAG = "WS2812";
 
+/*
+ * The strip driving each RMT channel, used to route the shared RMT transmit end
+ * callback back to its instance.
+ */
+static WS2812* s_channelStrips[RMT_CHANNEL_MAX] = { };
+static bool    s_txEndCallbackRegistered        = false;
+
 /**
  * A NeoPixel is defined by 3 bytes ... red, green and blue.
  * Each byte is composed of 8 bits ... therefore a NeoPixel is 24 bits of data.
@@ -28,34 +42,89 @@ static const char* LOG_TAG = "WS2812";
  */
 
 /**
- * Set two levels of RMT output to the Neopixel value for a "1".
- * This is:
- * a logic 1 for 0.7us
- * a logic 0 for 0.6us
+ * With the SPI output, each Neopixel bit is sent as several SPI bits of the same length: a high
+ * one, one holding the bit, then low ones.  The LED types set how many, see timing_t::slots.
+ * With 3 bits at 2.4MHz, ~0.42us each, a "1" is high for ~0.83us, within the WS2812 and WS2813
+ * windows but beyond the 0.75us allowed by the WS2811 and SK6812.  These use 4 bits at 3.2MHz,
+ * ~0.31us each, for 0.31us and 0.63us high times.  A channel takes as many bytes of SPI data as
+ * there are SPI bits per bit.
  */
-static void setItem1(rmt_item32_t* pItem) {
-	assert(pItem != nullptr);
-	pItem->level0    = 1;
-	pItem->duration0 = 10;
-	pItem->level1    = 0;
-	pItem->duration1 = 6;
-} // setItem1
 
+/**
+ * Bits of low level sent after the pixels to latch the frame, 300us of 1.25us bits.
+ */
+static const uint16_t SPI_RESET_BITS = 240;
+
+#define SPI_BIT(bit)       ((bit) ? 0x6 : 0x4)
+#define SPI_NIBBLE(nibble) (SPI_BIT((nibble) & 0x8) << 9 | SPI_BIT((nibble) & 0x4) << 6 | SPI_BIT((nibble) & 0x2) << 3 | SPI_BIT((nibble) & 0x1))
+#define SPI_BIT4(bit)       ((bit) ? 0xc : 0x8)
+#define SPI_NIBBLE4(nibble) (SPI_BIT4((nibble) & 0x8) << 12 | SPI_BIT4((nibble) & 0x4) << 8 | SPI_BIT4((nibble) & 0x2) << 4 | SPI_BIT4((nibble) & 0x1))
+
+/**
+ * The 12 SPI bits representing each nibble value with 3 bits per bit, most significant bit first.
+ */
+static const uint16_t SPI_NIBBLE_TABLE[16] = {
+	SPI_NIBBLE(0),  SPI_NIBBLE(1),  SPI_NIBBLE(2),  SPI_NIBBLE(3),
+	SPI_NIBBLE(4),  SPI_NIBBLE(5),  SPI_NIBBLE(6),  SPI_NIBBLE(7),
+	SPI_NIBBLE(8),  SPI_NIBBLE(9),  SPI_NIBBLE(10), SPI_NIBBLE(11),
+	SPI_NIBBLE(12), SPI_NIBBLE(13), SPI_NIBBLE(14), SPI_NIBBLE(15)
+};
 
+/**
+ * The 16 SPI bits representing each nibble value with 4 bits per bit, most significant bit first.
+ */
+static const uint16_t SPI_NIBBLE4_TABLE[16] = {
+	SPI_NIBBLE4(0),  SPI_NIBBLE4(1),  SPI_NIBBLE4(2),  SPI_NIBBLE4(3),
+	SPI_NIBBLE4(4),  SPI_NIBBLE4(5),  SPI_NIBBLE4(6),  SPI_NIBBLE4(7),
+	SPI_NIBBLE4(8),  SPI_NIBBLE4(9),  SPI_NIBBLE4(10), SPI_NIBBLE4(11),
+	SPI_NIBBLE4(12), SPI_NIBBLE4(13), SPI_NIBBLE4(14), SPI_NIBBLE4(15)
+};
 
 /**
- * Set two levels of RMT output to the Neopixel value for a "0".
- * This is:
- * a logic 1 for 0.35us
- * a logic 0 for 0.8us
+ * The RMT clock divider: RMT ticks last 100ns.
  */
-static void setItem0(rmt_item32_t* pItem) {
+#define RMT_CLK_DIV 8
+
+/**
+ * Convert a duration in ns into RMT ticks, rounded to the nearest tick.
+ */
+#define NS_TO_TICKS(ns) (((ns) * (APB_CLK_FREQ / 1000000) / RMT_CLK_DIV + 500) / 1000)
+
+/**
+ * The bit timings of an LED type, in RMT ticks, and its channels.
+ */
+typedef struct {
+	uint16_t    t0h;        // High time of a "0".
+	uint16_t    t0l;        // Low time of a "0".
+	uint16_t    t1h;        // High time of a "1".
+	uint16_t    t1l;        // Low time of a "1".
+	uint8_t     channelCount;
+	const char* colorOrder; // Default color order.
+	uint8_t     slots;      // SPI and I2S slots of a bit: 3 at 2.4MHz, or 4 at 3.2MHz.
+} timing_t;
+
+/**
+ * The timing profile of each ws2812_type_t, from the nominal datasheet timings in ns.
+ */
+static const timing_t TIMINGS[] = {
+	/* WS2812_TYPE_WS2812 */      { NS_TO_TICKS(400), NS_TO_TICKS(800), NS_TO_TICKS(1000), NS_TO_TICKS(600), 3, "GRB", 3 },
+	/* WS2812_TYPE_WS2811 */      { NS_TO_TICKS(250), NS_TO_TICKS(1000), NS_TO_TICKS(600), NS_TO_TICKS(650), 3, "RGB", 4 },
+	/* WS2812_TYPE_WS2813 */      { NS_TO_TICKS(350), NS_TO_TICKS(800), NS_TO_TICKS(800), NS_TO_TICKS(350), 3, "GRB", 3 },
+	/* WS2812_TYPE_SK6812 */      { NS_TO_TICKS(300), NS_TO_TICKS(900), NS_TO_TICKS(600), NS_TO_TICKS(600), 3, "GRB", 4 },
+	/* WS2812_TYPE_SK6812_RGBW */ { NS_TO_TICKS(300), NS_TO_TICKS(900), NS_TO_TICKS(600), NS_TO_TICKS(600), 4, "GRBW", 4 },
+};
+
+/**
+ * Set two levels of RMT output to a Neopixel bit: a logic 1 for the given high time
+ * followed by a logic 0 for the given low time, in RMT ticks.
+ */
+static void setItem(rmt_item32_t* pItem, uint16_t high, uint16_t low) {
 	assert(pItem != nullptr);
 	pItem->level0    = 1;
-	pItem->duration0 = 4;
+	pItem->duration0 = high;
 	pItem->level1    = 0;
-	pItem->duration1 = 8;
-} // setItem0
+	pItem->duration1 = low;
+} // setItem
 
 
 /**
@@ -70,25 +139,28 @@ static void setTerminator(rmt_item32_t* pItem) {
 } // setTerminator
 
 /*
- * Internal function not exposed.  Get the pixel channel color from the channel
- * type which should be one of 'R', 'G' or 'B'.
+ * Internal function not exposed.  Get the byte offset within a pixel_t of the channel
+ * type which should be one of 'R', 'G', 'B' or 'W'.  Returns -1 for an unknown type.
  */
-static uint8_t getChannelValueByType(char type, pixel_t pixel) {
+static int getChannelOffsetByType(char type) {
 	switch (type) {
 		case 'r':
 		case 'R':
-			return pixel.red;
+			return offsetof(pixel_t, red);
 		case 'b':
 		case 'B':
-			return pixel.blue;
+			return offsetof(pixel_t, blue);
 		case 'g':
 		case 'G':
-			return pixel.green;
+			return offsetof(pixel_t, green);
+		case 'w':
+		case 'W':
+			return offsetof(pixel_t, white);
 		default:
 			ESP_LOGW(LOG_TAG, "Unknown color channel 0x%2x", type);
-			return 0;
+			return -1;
 	}
-} // getChannelValueByType
+} // getChannelOffsetByType
 
 
 /**
@@ -102,9 +174,17 @@ static uint8_t getChannelValueByType(char type, pixel_t pixel) {
 
  * @param [in] dinPin The GPIO pin used to drive the data.
  * @param [in] pixelCount The number of pixels in the strand.
- * @param [in] channel The RMT channel to use.  Defaults to RMT_CHANNEL_0.
+ * @param [in] channel The RMT channel to use.  Defaults to RMT_CHANNEL_0.  For the WS2812_OUTPUT_SPI
+ * output, the SPI host to use instead, HSPI_HOST or VSPI_HOST.  Unused by the WS2812_OUTPUT_I2S output.
+ * @param [in] output How the pixel data is sent.  Defaults to WS2812_OUTPUT_RMT.
+ * @param [in] memBlocks The number of RMT memory blocks used by the channel.  Defaults to 0,
+ * which takes all the blocks from the channel up to the last one.
+ * @param [in] type The type of LEDs, which sets the bit timings, the number of channels and the
+ * default color order.  Defaults to WS2812_TYPE_WS2812.
+ * @param [in] placement Where the buffers are allocated.  Defaults to WS2812_PLACEMENT_INTERNAL.
  */
-WS2812::WS2812(gpio_num_t dinPin, uint16_t pixelCount, int channel) {
+WS2812::WS2812(gpio_num_t dinPin, uint16_t pixelCount, int channel, ws2812_output_t output, uint8_t memBlocks,
+		ws2812_type_t type, ws2812_placement_t placement) {
 	/*
 	if (pixelCount == 0) {
 		throw std::range_error("Pixel count was 0");
@@ -114,22 +194,65 @@ WS2812::WS2812(gpio_num_t dinPin, uint16_t pixelCount, int channel) {
 
 	this->pixelCount = pixelCount;
 	this->channel    = (rmt_channel_t) channel;
+	this->output     = output;
+	this->type       = type;
+	this->placement  = placement;
+	this->channelCount    = TIMINGS[type].channelCount;
+	this->slotsPerBit     = TIMINGS[type].slots;
+	this->whiteExtraction = true;
 
-	// The number of items is number of pixels * 24 bits per pixel + the terminator.
-	// Remember that an item is TWO RMT output bits ... for NeoPixels this is correct because
-	// on Neopixel bit is TWO bits of output ... the high value and the low value
-
-	this->items      = new rmt_item32_t[pixelCount * 24 + 1];
-	this->pixels     = new pixel_t[pixelCount];
-	this->colorOrder = (char*) "GRB";
+	// Buffers are double buffered, the second one is only allocated on the first showAsync().
+	this->items[0]     = nullptr;
+	this->items[1]     = nullptr;
+	this->wireBytes[0] = nullptr;
+	this->wireBytes[1] = nullptr;
+	this->spiBytes[0]  = nullptr;
+	this->spiBytes[1]  = nullptr;
+	this->spiDmaBytes  = nullptr;
+	this->encodedPixels      = 0;
+	this->totalEncodedPixels = 0;
+	this->frameCount         = 0;
+	this->transmitStart      = 0;
+	resetStats();
+	this->dirtyFrom[0] = this->dirtyFrom[1] = pixelCount;
+	this->dirtyTo[0]   = this->dirtyTo[1]   = 0;
+	allocateBuffer(0);
+	this->lastBuffer   = 0;
+	this->notifyTask   = nullptr;
+	this->pixels       = (uint32_t*) allocate("Pixels", pixelCount * sizeof(uint32_t), false);
+	memset(this->pixels, 0, pixelCount * sizeof(uint32_t));
+	for (uint8_t i = 0; i < 4; i++) {
+		this->wireShifts[i] = i * 8;
+	}
+	setColorOrder((char*) TIMINGS[type].colorOrder);
+	buildItemTable();
+	this->brightness  = 255;
+	this->ditherError = nullptr;
+	this->powerLimit  = 0;
+	this->powerScale  = 256;
+	this->estimatedCurrent = 0;
+	setChannelCurrents(20, 20, 20, 20);
+	setGamma(1.0f);
 	clear();
 
+	if (this->output == WS2812_OUTPUT_SPI) {
+		initSPI(dinPin, (spi_host_device_t) channel);
+	} else if (this->output != WS2812_OUTPUT_I2S) {
+		initRMT(dinPin, memBlocks);
+	}
+} // WS2812
+
+
+/**
+ * @brief Configure the RMT channel used by the WS2812_OUTPUT_RMT and WS2812_OUTPUT_RMT_STREAM outputs.
+ */
+void WS2812::initRMT(gpio_num_t dinPin, uint8_t memBlocks) {
 	rmt_config_t config;
 	config.rmt_mode                  = RMT_MODE_TX;
 	config.channel                   = this->channel;
 	config.gpio_num                  = dinPin;
-	config.mem_block_num             = 8 - this->channel;
-	config.clk_div                   = 8;
+	config.mem_block_num             = memBlocks > 0 ? memBlocks : 8 - this->channel;
+	config.clk_div                   = RMT_CLK_DIV;
 	config.tx_config.loop_en         = 0;
 	config.tx_config.carrier_en      = 0;
 	config.tx_config.idle_output_en  = 1;
@@ -140,44 +263,835 @@ WS2812::WS2812(gpio_num_t dinPin, uint16_t pixelCount, int channel) {
 
 	ESP_ERROR_CHECK(rmt_config(&config));
 	ESP_ERROR_CHECK(rmt_driver_install(this->channel, 0, 0));
-} // WS2812
+	if (this->output == WS2812_OUTPUT_RMT_STREAM) {
+		ESP_ERROR_CHECK(rmt_translator_init(this->channel, getTranslator(this->channel)));
+		int itemsSize = (pixelCount * this->channelCount * 8 + 1) * sizeof(rmt_item32_t);
+		int bytesSize = pixelCount * this->channelCount;
+		ESP_LOGI(LOG_TAG, "Streaming output: %d bytes of pixel data instead of %d bytes of RMT items, %d bytes of heap saved",
+			bytesSize, itemsSize, itemsSize - bytesSize);
+	}
+
+	s_channelStrips[this->channel] = this;
+	if (!s_txEndCallbackRegistered) {
+		rmt_register_tx_end_callback(txEndCallback, nullptr);
+		s_txEndCallbackRegistered = true;
+	}
+} // initRMT
 
 
 /**
- * @brief Show the current Neopixel data.
+ * @brief Configure the SPI bus used by the WS2812_OUTPUT_SPI output.
  *
- * Drive the LEDs with the values that were previously set.
+ * Only MOSI is connected.  The bus is clocked at 2.4MHz, 80MHz / 33 in practice, or at 3.2MHz,
+ * 80MHz / 25, so that the 3 or 4 SPI bits of the LED type last one WS2812 bit.  The transfers are done by DMA, using the DMA channel of the same
+ * number as the host.
  */
-void WS2812::show() {
-	auto pCurrentItem = this->items;
+void WS2812::initSPI(gpio_num_t dinPin, spi_host_device_t host) {
+	assert(host == HSPI_HOST || host == VSPI_HOST);
+	this->spiHost    = host;
+	this->spiPending = false;
+
+	spi_bus_config_t bus = { };
+	bus.mosi_io_num     = dinPin;
+	bus.miso_io_num     = -1;
+	bus.sclk_io_num     = -1;
+	bus.quadwp_io_num   = -1;
+	bus.quadhd_io_num   = -1;
+	bus.max_transfer_sz = getSPIFrameSize();
+	ESP_ERROR_CHECK(spi_bus_initialize(host, &bus, host /* DMA channel */));
+
+	spi_device_interface_config_t device = { };
+	device.clock_speed_hz = this->slotsPerBit * 800000;
+	device.mode           = 0;
+	device.spics_io_num   = -1;
+	device.queue_size     = 2;
+	device.post_cb        = spiPostCallback;
+	ESP_ERROR_CHECK(spi_bus_add_device(host, &device, &this->spiDevice));
+
+	int itemsSize = (this->pixelCount * this->channelCount * 8 + 1) * sizeof(rmt_item32_t);
+	ESP_LOGI(LOG_TAG, "SPI output: %d bytes of SPI data instead of %d bytes of RMT items",
+		(int) (getSPIFrameSize()), itemsSize);
+} // initSPI
+
+
+/**
+ * @brief Called from the RMT interrupt when a channel has sent all its items.
+ *
+ * Notify the task registered with setShowCompleteTask(), if any, of the end of the frame.
+ */
+void IRAM_ATTR WS2812::txEndCallback(rmt_channel_t channel, void* arg) {
+	WS2812* strip = s_channelStrips[channel];
+	if (strip != nullptr) {
+		strip->notifyShowComplete();
+	}
+} // txEndCallback
+
+
+/**
+ * @brief Called from the SPI interrupt when a transaction of the WS2812_OUTPUT_SPI output is done.
+ */
+void IRAM_ATTR WS2812::spiPostCallback(spi_transaction_t* transaction) {
+	((WS2812*) transaction->user)->notifyShowComplete();
+} // spiPostCallback
+
+
+/**
+ * @brief Notify the task registered with setShowCompleteTask(), if any, of the end of the frame.
+ *
+ * Also records the transmit time of the frame.  Called from interrupt context.
+ */
+void IRAM_ATTR WS2812::notifyShowComplete() {
+	uint32_t transmitUs = esp_timer_get_time() - this->transmitStart;
+	this->stats.lastTransmitUs = transmitUs;
+	if (transmitUs > this->stats.maxTransmitUs) {
+		this->stats.maxTransmitUs = transmitUs;
+	}
+
+	if (this->notifyTask == nullptr) {
+		return;
+	}
+	BaseType_t higherPriorityTaskWoken = pdFALSE;
+	vTaskNotifyGiveFromISR(this->notifyTask, &higherPriorityTaskWoken);
+	if (higherPriorityTaskWoken == pdTRUE) {
+		portYIELD_FROM_ISR();
+	}
+} // notifyShowComplete
+
+
+/**
+ * @brief RMT translator used by the WS2812_OUTPUT_RMT_STREAM output.
+ *
+ * Called by the RMT driver, from its interrupt as the RMT memory drains, to convert the next
+ * wire ordered pixel bytes into RMT items.  The translator interface carries no context, so
+ * there is one instance per channel to find the strip, and its item table, back.
+ */
+template<int CHANNEL>
+void IRAM_ATTR WS2812::translate(const void* src, rmt_item32_t* dest, size_t srcSize, size_t wantedNum,
+		size_t* translatedSize, size_t* itemNum) {
+	if (src == nullptr || dest == nullptr) {
+		*translatedSize = 0;
+		*itemNum        = 0;
+		return;
+	}
+	const WS2812*  strip = s_channelStrips[CHANNEL];
+	const uint8_t* pSrc  = (const uint8_t*) src;
+	size_t size = 0;
+	size_t num  = 0;
+	while (size < srcSize && num + 8 <= wantedNum) {
+		memcpy(dest + num, strip->itemTable[pSrc[size] >> 4], 4 * sizeof(rmt_item32_t));
+		memcpy(dest + num + 4, strip->itemTable[pSrc[size] & 0x0f], 4 * sizeof(rmt_item32_t));
+		num += 8;
+		size++;
+	}
+	*translatedSize = size;
+	*itemNum        = num;
+} // translate
+
+
+/**
+ * @brief Get the RMT translator of the given channel.
+ */
+sample_to_rmt_t WS2812::getTranslator(rmt_channel_t channel) {
+	static const sample_to_rmt_t translators[RMT_CHANNEL_MAX] = {
+		translate<0>, translate<1>, translate<2>, translate<3>,
+		translate<4>, translate<5>, translate<6>, translate<7>
+	};
+	return translators[channel];
+} // getTranslator
+
+
+/**
+ * @brief Allocate the given output buffer if it does not exist yet.
+ *
+ * The WS2812_OUTPUT_RMT output needs one item per bit, 24 per pixel, 32 for RGBW pixels, + the
+ * terminator item.
+ * Remember that an item is TWO RMT output bits ... for NeoPixels this is correct because
+ * on Neopixel bit is TWO bits of output ... the high value and the low value.
+ *
+ * The WS2812_OUTPUT_RMT_STREAM and WS2812_OUTPUT_I2S outputs only need the wire ordered bytes of
+ * each pixel.
+ *
+ * The WS2812_OUTPUT_SPI output needs 3 bytes of SPI data for each channel of each pixel, followed by the low
+ * bytes of the reset, in DMA capable memory.
+ *
+ * A newly allocated buffer is entirely dirty.
+ *
+ * With the WS2812_PLACEMENT_SPIRAM placement, the buffers go in PSRAM.  The RMT driver copies
+ * the items or wire bytes into the RMT memory with the CPU, from PSRAM as well as from internal
+ * RAM, but the SPI output needs an internal DMA capable buffer for the frame on the wire.
+ */
+void WS2812::allocateBuffer(uint8_t buffer) {
+	if (this->items[buffer] != nullptr || this->wireBytes[buffer] != nullptr || this->spiBytes[buffer] != nullptr) {
+		return;
+	}
+	this->dirtyFrom[buffer] = 0;
+	this->dirtyTo[buffer]   = this->pixelCount;
+
+	if (this->output == WS2812_OUTPUT_SPI) {
+		size_t size = getSPIFrameSize();
+		if (this->placement == WS2812_PLACEMENT_SPIRAM) {
+			// DMA cannot read PSRAM, so the frames are staged there and copied to a single DMA
+			// capable buffer when sent.
+			if (this->spiDmaBytes == nullptr) {
+				this->spiDmaBytes = (uint8_t*) allocate("SPI DMA buffer", size, true);
+				memset(this->spiDmaBytes, 0, size);
+			}
+			this->spiBytes[buffer] = (uint8_t*) allocate("SPI staging buffer", size, false);
+		} else {
+			this->spiBytes[buffer] = (uint8_t*) allocate("SPI buffer", size, true);
+		}
+		memset(this->spiBytes[buffer], 0, size);
+	} else if (this->output == WS2812_OUTPUT_RMT_STREAM || this->output == WS2812_OUTPUT_I2S) {
+		this->wireBytes[buffer] = (uint8_t*) allocate("Wire bytes", this->pixelCount * this->channelCount, false);
+	} else {
+		this->items[buffer] = (rmt_item32_t*) allocate("RMT items",
+			(this->pixelCount * this->channelCount * 8 + 1) * sizeof(rmt_item32_t), false);
+		setTerminator(this->items[buffer] + this->pixelCount * this->channelCount * 8); // Write the RMT terminator.
+	}
+} // allocateBuffer
+
+
+/**
+ * @brief Allocate a buffer according to the placement of the strip and log where it landed.
+ *
+ * Buffers that are not read by DMA go in PSRAM with the WS2812_PLACEMENT_SPIRAM placement, or
+ * in internal RAM if PSRAM is missing or full.
+ *
+ * @param [in] name The name of the buffer, for the log.
+ * @param [in] size The size of the buffer in bytes.
+ * @param [in] dma Whether the buffer is read by DMA, and must be in internal DMA capable RAM.
+ * @return The buffer, to be freed with heap_caps_free().
+ */
+void* WS2812::allocate(const char* name, size_t size, bool dma) {
+	// heap_caps_malloc() returns nullptr for 0 bytes, and a strip may have no pixels until it is
+	// configured.
+	if (size == 0) {
+		size = 1;
+	}
+	void* pBuffer = nullptr;
+	if (dma) {
+		pBuffer = heap_caps_malloc(size, MALLOC_CAP_DMA);
+	} else {
+		if (this->placement == WS2812_PLACEMENT_SPIRAM) {
+			pBuffer = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+		}
+		if (pBuffer == nullptr) {
+			pBuffer = heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+		}
+	}
+	assert(pBuffer != nullptr);
+	ESP_LOGI(LOG_TAG, "%s: %d bytes in %s", name, (int) size,
+		esp_ptr_external_ram(pBuffer) ? "PSRAM" : dma ? "DMA capable RAM" : "internal RAM");
+	return pBuffer;
+} // allocate
+
+
+/**
+ * @brief Mark a range of pixels as changed since they were last encoded.
+ *
+ * Each output buffer keeps its own dirty range, since they are not encoded by the same frames.
+ *
+ * @param [in] from The first changed pixel.
+ * @param [in] to The pixel following the last changed one.
+ */
+inline void WS2812::markDirty(uint16_t from, uint16_t to) {
+	for (uint8_t buffer = 0; buffer < 2; buffer++) {
+		if (from < this->dirtyFrom[buffer]) {
+			this->dirtyFrom[buffer] = from;
+		}
+		if (to > this->dirtyTo[buffer]) {
+			this->dirtyTo[buffer] = to;
+		}
+	}
+} // markDirty
+
+
+/**
+ * @brief Build the nibble to RMT items lookup table.
+ *
+ * Each of the 16 possible nibble values is expanded once into the 4 RMT items that
+ * represent it on the wire with the timings of the LED type, most significant bit first.  The encoder in show() can
+ * then emit a whole data byte as two 4 word copies instead of 8 bit tests.
+ */
+void WS2812::buildItemTable() {
+	const timing_t* timing = &TIMINGS[this->type];
+	rmt_item32_t item1;
+	rmt_item32_t item0;
+	setItem(&item1, timing->t1h, timing->t1l);
+	setItem(&item0, timing->t0h, timing->t0l);
+
+	for (uint8_t nibble = 0; nibble < 16; nibble++) {
+		for (uint8_t bit = 0; bit < 4; bit++) {
+			this->itemTable[nibble][bit] = (nibble & (0x08 >> bit)) ? item1.val : item0.val;
+		}
+	}
+} // buildItemTable
+
+
+/*
+ * Internal function not exposed.  Write the 3 SPI bytes representing the given byte, most
+ * significant bit first, and return the position following them.
+ */
+static inline uint8_t* encodeSPIByte(uint8_t value, uint8_t* pByte) {
+	uint32_t bits = ((uint32_t) SPI_NIBBLE_TABLE[value >> 4] << 12) | SPI_NIBBLE_TABLE[value & 0x0f];
+	pByte[0] = bits >> 16;
+	pByte[1] = bits >> 8;
+	pByte[2] = bits;
+	return pByte + 3;
+} // encodeSPIByte
+
+
+/*
+ * Internal function not exposed.  Write the 4 SPI bytes representing the given byte with 4 SPI
+ * bits per bit, most significant bit first, and return the position following them.
+ */
+static inline uint8_t* encodeSPIByte4(uint8_t value, uint8_t* pByte) {
+	uint16_t high = SPI_NIBBLE4_TABLE[value >> 4];
+	uint16_t low  = SPI_NIBBLE4_TABLE[value & 0x0f];
+	pByte[0] = high >> 8;
+	pByte[1] = high;
+	pByte[2] = low >> 8;
+	pByte[3] = low;
+	return pByte + 4;
+} // encodeSPIByte4
+
+
+/*
+ * Internal function not exposed.  Write the 8 RMT items representing the given byte,
+ * most significant bit first, and return the position following them.
+ */
+static inline rmt_item32_t* encodeByte(const uint32_t itemTable[16][4], uint8_t value, rmt_item32_t* pItem) {
+	memcpy(pItem, itemTable[value >> 4], 4 * sizeof(rmt_item32_t));
+	memcpy(pItem + 4, itemTable[value & 0x0f], 4 * sizeof(rmt_item32_t));
+	return pItem + 8;
+} // encodeByte
+
+
+/*
+ * Internal function not exposed.  Copy the first unit of the given size over the following
+ * count - 1 units, doubling the size of the copied block at each step.
+ */
+static void replicate(uint8_t* pFirstUnit, size_t unitSize, uint16_t count) {
+	size_t filled = unitSize;
+	size_t total  = unitSize * count;
+	while (filled < total) {
+		size_t size = filled < total - filled ? filled : total - filled;
+		memcpy(pFirstUnit + filled, pFirstUnit, size);
+		filled += size;
+	}
+} // replicate
+
+
+/**
+ * @brief Get the number of consecutive pixels identical to the given one.
+ *
+ * @param [in] from The first pixel of the run.
+ * @param [in] to The pixel following the last one that can be part of the run.
+ * @return The length of the run, at least 1.
+ */
+uint16_t WS2812::getRunLength(uint16_t from, uint16_t to) {
+	const uint32_t pixel = this->pixels[from];
+	uint16_t i = from + 1;
+	while (i < to && this->pixels[i] == pixel) {
+		i++;
+	}
+	return i - from;
+} // getRunLength
+
+
+/**
+ * @brief Convert a pixel into its wire ordered word.
+ *
+ * @param [in] pixel The pixel.
+ * @return The word holding the channels of the pixel, the first one sent in the low byte.
+ */
+inline uint32_t WS2812::toWire(pixel_t pixel) {
+	return (uint32_t) pixel.red << this->wireShifts[offsetof(pixel_t, red)]
+		| (uint32_t) pixel.green << this->wireShifts[offsetof(pixel_t, green)]
+		| (uint32_t) pixel.blue << this->wireShifts[offsetof(pixel_t, blue)]
+		| (uint32_t) pixel.white << this->wireShifts[offsetof(pixel_t, white)];
+} // toWire
+
+
+/**
+ * @brief Convert a wire ordered word back into a pixel.
+ *
+ * @param [in] word The word holding the channels of the pixel.
+ * @return The pixel.
+ */
+inline pixel_t WS2812::fromWire(uint32_t word) {
+	pixel_t pixel;
+	pixel.red   = word >> this->wireShifts[offsetof(pixel_t, red)];
+	pixel.green = word >> this->wireShifts[offsetof(pixel_t, green)];
+	pixel.blue  = word >> this->wireShifts[offsetof(pixel_t, blue)];
+	pixel.white = word >> this->wireShifts[offsetof(pixel_t, white)];
+	return pixel;
+} // fromWire
+
+
+/**
+ * @brief Get the channel values of a pixel, in wire order.
+ *
+ * For RGBW strips with white extraction, the white common to the red, green and blue
+ * channels is moved to the white channel, subtracting it from the three of them at once.
+ *
+ * @param [in] pixel The wire ordered word of the pixel.
+ * @param [out] pValues The channel values, channelCount of them.
+ */
+inline void WS2812::getWireValues(uint32_t pixel, uint8_t* pValues) {
+	if (this->channelCount == 4 && this->whiteExtraction) {
+		const uint8_t red   = pixel >> this->wireShifts[offsetof(pixel_t, red)];
+		const uint8_t green = pixel >> this->wireShifts[offsetof(pixel_t, green)];
+		const uint8_t blue  = pixel >> this->wireShifts[offsetof(pixel_t, blue)];
+		uint8_t white = red < green ? red : green;
+		if (blue < white) {
+			white = blue;
+		}
+		if (white > 0) {
+			const uint8_t  whiteShift = this->wireShifts[offsetof(pixel_t, white)];
+			const uint32_t current    = (pixel >> whiteShift) & 0xff;
+			const uint32_t extracted  = current + white > 255 ? 255 : current + white;
+			// No channel borrows from the next one since white is their minimum.
+			pixel -= white * this->colorMask;
+			pixel += (extracted - current) << whiteShift;
+		}
+	}
+	for (uint8_t i = 0; i < this->channelCount; i++) {
+		pValues[i] = pixel >> (i * 8);
+	}
+} // getWireValues
+
+
+/**
+ * @brief Get the size of the encoded data of a pixel in the output buffers.
+ */
+inline size_t WS2812::getEncodedPixelSize() {
+	if (this->output == WS2812_OUTPUT_SPI) {
+		return this->channelCount * this->slotsPerBit;
+	}
+	if (this->output == WS2812_OUTPUT_RMT_STREAM || this->output == WS2812_OUTPUT_I2S) {
+		return this->channelCount;
+	}
+	return this->channelCount * 8 * sizeof(rmt_item32_t);
+} // getEncodedPixelSize
+
+
+/**
+ * @brief Get the size of the SPI data of a frame of the WS2812_OUTPUT_SPI output, the pixels
+ * followed by the reset bytes.
+ */
+size_t WS2812::getSPIFrameSize() {
+	return this->pixelCount * getEncodedPixelSize() + SPI_RESET_BITS * this->slotsPerBit / 8;
+} // getSPIFrameSize
+
+
+/**
+ * @brief Write the encoded data of a pixel into the given output buffer.
+ *
+ * @param [in] buffer The output buffer.
+ * @param [in] index The pixel.
+ * @param [in] pLevels The levels of its channels, in wire order.
+ * @return The start of the encoded data of the pixel.
+ */
+inline uint8_t* WS2812::encodePixel(uint8_t buffer, uint16_t index, const uint8_t* pLevels) {
+	if (this->output == WS2812_OUTPUT_SPI) {
+		uint8_t* pFirstByte   = this->spiBytes[buffer] + index * this->channelCount * this->slotsPerBit;
+		uint8_t* pCurrentByte = pFirstByte;
+		for (uint8_t i = 0; i < this->channelCount; i++) {
+			pCurrentByte = this->slotsPerBit == 4 ? encodeSPIByte4(pLevels[i], pCurrentByte)
+				: encodeSPIByte(pLevels[i], pCurrentByte);
+		}
+		return pFirstByte;
+	}
+
+	if (this->output == WS2812_OUTPUT_RMT_STREAM || this->output == WS2812_OUTPUT_I2S) {
+		uint8_t* pFirstByte = this->wireBytes[buffer] + index * this->channelCount;
+		memcpy(pFirstByte, pLevels, this->channelCount);
+		return pFirstByte;
+	}
+
+	// Each channel byte is streamed through RMT most significant bit first, in the
+	// order expected by the LEDs.
+	rmt_item32_t* pFirstItem   = this->items[buffer] + index * this->channelCount * 8;
+	rmt_item32_t* pCurrentItem = pFirstItem;
+	for (uint8_t i = 0; i < this->channelCount; i++) {
+		pCurrentItem = encodeByte(this->itemTable, pLevels[i], pCurrentItem);
+	}
+	return (uint8_t*) pFirstItem;
+} // encodePixel
+
+
+/**
+ * @brief Encode the current pixel data into the given output buffer.
+ *
+ * For the WS2812_OUTPUT_RMT output, the pixels are expanded into RMT items.  For the
+ * WS2812_OUTPUT_RMT_STREAM and WS2812_OUTPUT_I2S outputs they are only put in wire order, the
+ * translator or the WS2812I2S doing the expansion while sending.  For the WS2812_OUTPUT_SPI output, they are expanded into
+ * 3 or 4 SPI bits per bit, the reset bytes that follow never change.
+ *
+ * The buffers persist from frame to frame, so only the pixels changed since the buffer was last
+ * encoded are encoded again.
+ */
+void WS2812::encode(uint8_t buffer) {
+	const int64_t start = esp_timer_get_time();
+	// Dithered frames differ from the previous ones even when the pixels do not, and the
+	// power limiter needs the levels of the whole frame.
+	const bool     dithering = this->ditherError != nullptr;
+	const bool     fullFrame = dithering || this->powerLimit > 0;
+	const uint16_t from  = fullFrame ? 0 : this->dirtyFrom[buffer];
+	const uint16_t to    = fullFrame ? this->pixelCount : this->dirtyTo[buffer];
+
+	this->dirtyFrom[buffer] = this->pixelCount;
+	this->dirtyTo[buffer]   = 0;
+	this->encodedPixels     = from < to ? to - from : 0;
+	this->totalEncodedPixels += this->encodedPixels;
+	this->frameCount++;
+
+	uint32_t sums[4] = { 0, 0, 0, 0 };
+	if (dithering) {
+		encodeDithered(buffer, this->powerLimit > 0 ? sums : nullptr);
+		if (this->powerLimit > 0 && limitPower(sums)) {
+			encodeDithered(buffer, nullptr);
+		}
+	} else {
+		encodeRange(buffer, from, to, sums);
+		if (this->powerLimit > 0 && limitPower(sums)) {
+			encodeRange(buffer, 0, this->pixelCount, nullptr);
+		}
+	}
+
+	uint32_t encodeUs = esp_timer_get_time() - start;
+	this->stats.lastEncodeUs = encodeUs;
+	if (encodeUs > this->stats.maxEncodeUs) {
+		this->stats.maxEncodeUs = encodeUs;
+	}
+	uint8_t bucket = encodeUs < 64 ? 0 : 26 - __builtin_clz(encodeUs);
+	this->stats.encodeHistogram[bucket < WS2812_STATS_BUCKETS ? bucket : WS2812_STATS_BUCKETS - 1]++;
+} // encode
+
+
+/**
+ * @brief Encode a range of pixels into the given output buffer.
+ *
+ * Runs of identical pixels, such as the ones written by fill(), are only encoded once and the
+ * result is replicated over the run.
+ *
+ * @param [in] buffer The output buffer to encode into.
+ * @param [in] from The first pixel to encode.
+ * @param [in] to The pixel following the last one to encode.
+ * @param [out] pSums The sums of the levels sent on each channel, in wire order, or nullptr.
+ */
+void WS2812::encodeRange(uint8_t buffer, uint16_t from, uint16_t to, uint32_t* pSums) {
+	const uint8_t* levels = this->levelTable;
+	const size_t   size   = getEncodedPixelSize();
+	for (uint16_t i = from; i < to;) {
+		uint8_t values[4];
+		getWireValues(this->pixels[i], values);
+		for (uint8_t j = 0; j < this->channelCount; j++) {
+			values[j] = levels[values[j]];
+		}
+		uint8_t* pEncoded = encodePixel(buffer, i, values);
+		uint16_t run = getRunLength(i, to);
+		replicate(pEncoded, size, run);
+		if (pSums != nullptr) {
+			for (uint8_t j = 0; j < this->channelCount; j++) {
+				pSums[j] += values[j] * run;
+			}
+		}
+		i += run;
+	}
+} // encodeRange
+
+
+/**
+ * @brief Keep the current drawn by a frame within the power limit.
+ *
+ * The current is estimated from the levels sent, each channel drawing its full current at
+ * level 255.  When it exceeds the limit, the scale needed to fit is folded into the level
+ * table, and the frame must be encoded again.  That is the only case where a frame is encoded
+ * twice, the dithering errors being first taken back to where they were before the frame.  When
+ * the frame would fit with less scaling, the scale is raised for the following frames.
+ *
+ * @param [in] pSums The sums of the levels sent on each channel, in wire order.
+ * @return True if the scale dropped, and the frame must be encoded with the new level table.
+ */
+bool WS2812::limitPower(const uint32_t* pSums) {
+	// Currents are accumulated in mA * 255.
+	uint64_t current = 0;
+	for (uint8_t j = 0; j < this->channelCount; j++) {
+		current += (uint64_t) pSums[j] * this->channelCurrents[this->colorOffsets[j]];
+	}
+	this->estimatedCurrent = current / 255;
+
+	const uint64_t limit     = (uint64_t) this->powerLimit * 255;
+	const uint64_t unlimited = current * 256 / this->powerScale;
+	uint16_t scale = 256;
+	if (unlimited > limit) {
+		scale = limit * 256 / unlimited;
+		if (scale == 0) {
+			scale = 1;
+		}
+	}
 
+	if (scale < this->powerScale) {
+		if (this->ditherError != nullptr) {
+			rewindDithering(); // Needs the level table the frame was encoded with.
+		}
+		this->estimatedCurrent = this->estimatedCurrent * scale / this->powerScale;
+		this->powerScale = scale;
+		buildLevelTable();
+		return true;
+	}
+	if (scale > this->powerScale + 2 || (scale == 256 && this->powerScale != 256)) {
+		// Small increases are ignored so that rounding does not change the scale every frame.
+		this->powerScale = scale;
+		buildLevelTable();
+	}
+	return false;
+} // limitPower
+
+
+/**
+ * @brief Take the dithering errors back to where they were before the last dithered frame.
+ *
+ * Each error was advanced by the fractional bits of the level of its channel, which the dither
+ * level table still gives as long as neither the table nor the pixels changed.
+ */
+void WS2812::rewindDithering() {
+	const uint16_t* levels = this->ditherLevelTable;
+	uint8_t* pError = this->ditherError;
+	for (uint16_t i = 0; i < this->pixelCount; i++) {
+		uint8_t values[4];
+		getWireValues(this->pixels[i], values);
+		for (uint8_t j = 0; j < this->channelCount; j++) {
+			pError[j] -= levels[values[j]];
+		}
+		pError += this->channelCount;
+	}
+} // rewindDithering
+
+
+/**
+ * @brief Encode all the pixels into the given output buffer with temporal dithering.
+ *
+ * Each channel level is kept with 8 fractional bits: the fraction left over by a frame is
+ * accumulated in ditherError and carried into the next frames, so that levels between two
+ * 8-bit values are rendered by alternating them.  This costs 1 byte per channel and a few
+ * operations per channel, and runs of identical pixels are no longer replicated since their
+ * errors differ.
+ *
+ * @param [in] buffer The output buffer to encode into.
+ * @param [out] pSums The sums of the levels sent on each channel, in wire order, or nullptr.
+ */
+void WS2812::encodeDithered(uint8_t buffer, uint32_t* pSums) {
+	const uint16_t* levels = this->ditherLevelTable;
+	uint8_t* pError = this->ditherError;
 	for (uint16_t i = 0; i < this->pixelCount; i++) {
-		uint32_t currentPixel =
-				(getChannelValueByType(this->colorOrder[0], this->pixels[i]) << 16) |
-				(getChannelValueByType(this->colorOrder[1], this->pixels[i]) << 8)  |
-				(getChannelValueByType(this->colorOrder[2], this->pixels[i]));
-
-		ESP_LOGD(LOG_TAG, "Pixel value: %x", currentPixel);
-		for (int8_t j = 23; j >= 0; j--) {
-			// We have 24 bits of data representing the red, green amd blue channels. The value of the
-			// 24 bits to output is in the variable current_pixel.  We now need to stream this value
-			// through RMT in most significant bit first.  To do this, we iterate through each of the 24
-			// bits from MSB to LSB.
-			if (currentPixel & (1 << j)) {
-				setItem1(pCurrentItem);
-			} else {
-				setItem0(pCurrentItem);
+		uint8_t values[4];
+		getWireValues(this->pixels[i], values);
+		for (uint8_t j = 0; j < this->channelCount; j++) {
+			uint16_t level = levels[values[j]] + pError[j];
+			values[j] = level >> 8;
+			pError[j] = level & 0xff;
+		}
+		pError += this->channelCount;
+		encodePixel(buffer, i, values);
+		if (pSums != nullptr) {
+			for (uint8_t j = 0; j < this->channelCount; j++) {
+				pSums[j] += values[j];
 			}
-			pCurrentItem++;
 		}
 	}
-	setTerminator(pCurrentItem); // Write the RMT terminator.
+} // encodeDithered
+
+
+/**
+ * @brief Get the number of pixels encoded by the last show operation.
+ *
+ * Only the pixels changed since the output buffer was last sent are encoded.
+ */
+uint16_t WS2812::getEncodedPixelCount() {
+	return this->encodedPixels;
+} // getEncodedPixelCount
+
+
+/**
+ * @brief Get the number of pixels encoded since the strip was created.
+ */
+uint32_t WS2812::getTotalEncodedPixelCount() {
+	return this->totalEncodedPixels;
+} // getTotalEncodedPixelCount
+
+
+/**
+ * @brief Get the number of frames shown since the strip was created.
+ */
+uint32_t WS2812::getFrameCount() {
+	return this->frameCount;
+} // getFrameCount
+
+
+/**
+ * @brief Get the timings of the frames shown since the strip was created or the stats reset.
+ *
+ * @param [out] pStats The timings.
+ */
+void WS2812::getStats(ws2812_stats_t* pStats) {
+	memcpy(pStats, &this->stats, sizeof(ws2812_stats_t));
+} // getStats
+
+
+/**
+ * @brief Reset the timings of the frames shown.
+ */
+void WS2812::resetStats() {
+	memset(&this->stats, 0, sizeof(ws2812_stats_t));
+} // resetStats
+
+
+/**
+ * @brief Start sending the given, already encoded, output buffer.
+ *
+ * @param [in] buffer The output buffer to send.
+ * @param [in] wait Whether to wait for the whole frame to be sent.
+ */
+void WS2812::transmit(uint8_t buffer, bool wait) {
+	int64_t now = esp_timer_get_time();
+	if (this->stats.frames > 0) {
+		uint32_t intervalUs = now - this->transmitStart;
+		this->stats.lastIntervalUs = intervalUs;
+		if (intervalUs > this->stats.maxIntervalUs) {
+			this->stats.maxIntervalUs = intervalUs;
+		}
+	}
+	this->stats.frames++;
+	this->transmitStart = now;
+
+	if (this->output == WS2812_OUTPUT_SPI) {
+		spi_transaction_t* transaction = &this->spiTransactions[buffer];
+		memset(transaction, 0, sizeof(spi_transaction_t));
+		transaction->length    = (getSPIFrameSize()) * 8;
+		transaction->tx_buffer = this->spiBytes[buffer];
+		if (this->spiDmaBytes != nullptr) {
+			// The previous frame has been sent, its DMA buffer is free.
+			memcpy(this->spiDmaBytes, this->spiBytes[buffer], this->pixelCount * getEncodedPixelSize());
+			transaction->tx_buffer = this->spiDmaBytes;
+		}
+		transaction->user      = this;
+		ESP_ERROR_CHECK(spi_device_queue_trans(this->spiDevice, transaction, portMAX_DELAY));
+		this->spiPending = true;
+		if (wait) {
+			waitShowComplete(portMAX_DELAY);
+		}
+	} else if (this->output == WS2812_OUTPUT_I2S) {
+		// The wire bytes are sent by the WS2812I2S owning the strip, which calls notifyShowComplete().
+	} else if (this->output == WS2812_OUTPUT_RMT_STREAM) {
+		ESP_ERROR_CHECK(rmt_write_sample(this->channel, this->wireBytes[buffer], this->pixelCount * this->channelCount, wait));
+	} else {
+		ESP_ERROR_CHECK(rmt_write_items(this->channel, this->items[buffer], this->pixelCount * this->channelCount * 8, wait));
+	}
+} // transmit
+
+
+/**
+ * @brief Show the current Neopixel data.
+ *
+ * Drive the LEDs with the values that were previously set.  The call only returns once the
+ * whole frame has been sent.
+ */
+void WS2812::show() {
+	// A frame started by showAsync() may still be reading the buffer.
+	waitShowComplete(portMAX_DELAY);
+	encode(0);
+	this->lastBuffer = 0;
 
 	// Show the pixels.
-	ESP_ERROR_CHECK(rmt_write_items(this->channel, this->items, this->pixelCount * 24, 1 /* wait till done */));
+	transmit(0, true /* wait till done */);
 } // show
 
 
+/**
+ * @brief Show the current Neopixel data without waiting for it to be sent.
+ *
+ * The pixels are encoded into the buffer that is not on the wire, so that the next frame
+ * can be prepared while the previous one is still being sent.  The call only waits for the
+ * previous frame to complete before starting the transmission of this one.  The end of the
+ * transmission is signaled to the task set with setShowCompleteTask(), and can also be
+ * waited for with waitShowComplete().
+ *
+ * The second output buffer is allocated on the first call.
+ */
+void WS2812::showAsync() {
+	startAsync(prepareAsync());
+} // showAsync
+
+
+/**
+ * @brief Encode the current pixel data into the output buffer that is not on the wire.
+ *
+ * @return The output buffer to pass to startAsync().
+ */
+uint8_t WS2812::prepareAsync() {
+	uint8_t buffer = this->lastBuffer ^ 1;
+	allocateBuffer(buffer);
+	encode(buffer);
+	return buffer;
+} // prepareAsync
+
+
+/**
+ * @brief Wait for the previous frame to be sent and start sending the given output buffer.
+ *
+ * @param [in] buffer The output buffer returned by prepareAsync().
+ */
+void WS2812::startAsync(uint8_t buffer) {
+	if (!waitShowComplete(0)) {
+		this->stats.stalledFrames++;
+		waitShowComplete(portMAX_DELAY);
+	}
+	this->lastBuffer = buffer;
+	transmit(buffer, false /* do not wait */);
+} // startAsync
+
+
+/**
+ * @brief Wait for the frame started by the last show operation to be sent.
+ *
+ * @param [in] waitTicks The maximum number of ticks to wait.
+ * @return True if the frame has been sent, false on timeout.
+ */
+bool WS2812::waitShowComplete(TickType_t waitTicks) {
+	if (this->output == WS2812_OUTPUT_SPI) {
+		if (!this->spiPending) {
+			return true;
+		}
+		spi_transaction_t* transaction;
+		if (spi_device_get_trans_result(this->spiDevice, &transaction, waitTicks) != ESP_OK) {
+			return false;
+		}
+		this->spiPending = false;
+		return true;
+	}
+	if (this->output == WS2812_OUTPUT_I2S) {
+		return true;
+	}
+	return rmt_wait_tx_done(this->channel, waitTicks) == ESP_OK;
+} // waitShowComplete
+
+
+/**
+ * @brief Set the task to notify each time a frame has been sent.
+ *
+ * The task is notified from the RMT interrupt with vTaskNotifyGiveFromISR(), so it can
+ * wait for the end of a frame with ulTaskNotifyTake().
+ *
+ * @param [in] task The task to notify, or nullptr to disable notifications.
+ */
+void WS2812::setShowCompleteTask(TaskHandle_t task) {
+	this->notifyTask = task;
+} // setShowCompleteTask
+
+
 /**
  * @brief Set the color order of data sent to the LEDs.
  *
@@ -188,15 +1102,265 @@ void WS2812::show() {
  * have their own orders.  This function can be called to override the default ordering of "GRB".
  * We can specify
  * an alternate order by supply an alternate three character string made up of 'R', 'G' and 'B'
- * for example "RGB".
+ * for example "RGB".  RGBW LEDs take a four character string that also includes 'W', for
+ * example "GRBW".
+ *
+ * The order is resolved here, once, into the byte offset of each channel within a pixel_t so
+ * that show() never has to look at it again.  An order that is not a permutation of the channels of
+ * the strip, with an unknown or repeated channel, or 'W' on an RGB strip, is ignored and the previous
+ * order is kept.
  */
 void WS2812::setColorOrder(char* colorOrder) {
-	if (colorOrder != nullptr && strlen(colorOrder) == 3) {
-		this->colorOrder = colorOrder;
+	uint8_t colorOffsets[4];
+	if (!parseColorOrder(colorOrder, colorOffsets, this->channelCount)) {
+		ESP_LOGW(LOG_TAG, "Ignoring the color order %s, keeping the previous one", colorOrder == nullptr ? "(null)" : colorOrder);
+		return;
+	}
+
+	// Each channel must get its own byte of the pixel words, or the pixels would be corrupted.
+	uint8_t newShifts[4];
+	// The white of RGB LEDs is kept in the byte that is not sent.
+	newShifts[offsetof(pixel_t, white)] = 24;
+	for (uint8_t i = 0; i < this->channelCount; i++) {
+		newShifts[colorOffsets[i]] = i * 8;
+	}
+	uint8_t shiftsSet = 0;
+	for (uint8_t j = 0; j < 4; j++) {
+		shiftsSet |= 1 << (newShifts[j] / 8);
+	}
+	if (shiftsSet != 0x0f) {
+		ESP_LOGW(LOG_TAG, "Ignoring the color order %s, keeping the previous one", colorOrder);
+		return;
+	}
+	memcpy(this->colorOffsets, colorOffsets, this->channelCount);
+
+	// The pixels are stored in wire order, so they are converted to the new one.
+	uint8_t wireShifts[4];
+	memcpy(wireShifts, this->wireShifts, sizeof(wireShifts));
+	memcpy(this->wireShifts, newShifts, sizeof(newShifts));
+	this->colorMask = (uint32_t) 1 << this->wireShifts[offsetof(pixel_t, red)]
+		| (uint32_t) 1 << this->wireShifts[offsetof(pixel_t, green)]
+		| (uint32_t) 1 << this->wireShifts[offsetof(pixel_t, blue)];
+	if (memcmp(wireShifts, this->wireShifts, sizeof(wireShifts)) != 0) {
+		for (uint16_t i = 0; i < this->pixelCount; i++) {
+			uint32_t word = this->pixels[i];
+			this->pixels[i] = 0;
+			for (uint8_t j = 0; j < 4; j++) {
+				this->pixels[i] |= ((word >> wireShifts[j]) & 0xff) << this->wireShifts[j];
+			}
+		}
 	}
+	markDirty(0, this->pixelCount);
 } // setColorOrder
 
 
+/**
+ * @brief Set whether the white of RGB colors is sent to the white channel of RGBW LEDs.
+ *
+ * With white extraction, which is the default, the part of a color common to its red, green
+ * and blue channels is moved to the white channel, which renders it with a single LED instead
+ * of three.  It has no effect on RGB LEDs.  The LEDs are not actually updated until a call to
+ * show().
+ *
+ * @param [in] enabled Whether the white is extracted.
+ */
+void WS2812::setWhiteExtraction(bool enabled) {
+	this->whiteExtraction = enabled;
+	markDirty(0, this->pixelCount);
+} // setWhiteExtraction
+
+
+/**
+ * @brief Get the type of LEDs driven.
+ */
+ws2812_type_t WS2812::getType() {
+	return this->type;
+} // getType
+
+
+/**
+ * @brief Get the number of channels of each pixel on the wire, 3 or 4 for RGBW LEDs.
+ */
+uint8_t WS2812::getChannelCount() {
+	return this->channelCount;
+} // getChannelCount
+
+
+/**
+ * @brief Set the maximum current the strip may draw.
+ *
+ * The current of each frame is estimated while it is encoded.  Frames that would draw more
+ * are dimmed evenly to fit, see getPowerScale().  Every frame is then fully encoded.
+ *
+ * @param [in] milliamps The maximum current in mA, or 0 (the default) to disable the limit.
+ */
+void WS2812::setPowerLimit(uint32_t milliamps) {
+	this->powerLimit = milliamps;
+	if (milliamps == 0 && this->powerScale != 256) {
+		this->powerScale = 256;
+		buildLevelTable();
+	}
+} // setPowerLimit
+
+
+/**
+ * @brief Set the current drawn by each channel of a pixel at full level.
+ *
+ * These are used by the power limit.  They default to 20mA per channel.
+ *
+ * @param [in] red The current of the red channel in mA.
+ * @param [in] green The current of the green channel in mA.
+ * @param [in] blue The current of the blue channel in mA.
+ * @param [in] white The current of the white channel in mA, for RGBW LEDs.
+ */
+void WS2812::setChannelCurrents(uint8_t red, uint8_t green, uint8_t blue, uint8_t white) {
+	this->channelCurrents[offsetof(pixel_t, red)]   = red;
+	this->channelCurrents[offsetof(pixel_t, green)] = green;
+	this->channelCurrents[offsetof(pixel_t, blue)]  = blue;
+	this->channelCurrents[offsetof(pixel_t, white)] = white;
+} // setChannelCurrents
+
+
+/**
+ * @brief Get the scale applied by the power limit to the last frame.
+ *
+ * @return The scale in 1/256, 256 when the frame was not dimmed.
+ */
+uint16_t WS2812::getPowerScale() {
+	return this->powerScale;
+} // getPowerScale
+
+
+/**
+ * @brief Get the estimated current drawn by the last frame sent, in mA.
+ *
+ * The estimate only covers the channels of the LEDs and is only computed when a power limit
+ * is set.
+ */
+uint32_t WS2812::getEstimatedCurrent() {
+	return this->estimatedCurrent;
+} // getEstimatedCurrent
+
+
+/**
+ * @brief Set the master brightness of the strip.
+ *
+ * The brightness scales every channel while the pixels are encoded, the pixel colors are kept
+ * as they were set.  The LEDs are not actually updated until a call to show().
+ *
+ * @param [in] brightness The brightness, from 0 (off) to 255 (full brightness, the default).
+ */
+void WS2812::setBrightness(uint8_t brightness) {
+	this->brightness = brightness;
+	buildLevelTable();
+} // setBrightness
+
+
+/**
+ * @brief Get the master brightness of the strip.
+ *
+ * @return The brightness, from 0 to 255.
+ */
+uint8_t WS2812::getBrightness() {
+	return this->brightness;
+} // getBrightness
+
+
+/**
+ * @brief Set the gamma correction applied to the pixel colors.
+ *
+ * Each channel value v is sent as 255 * (v / 255) ^ gamma, before the brightness is applied.
+ * The LEDs are not actually updated until a call to show().
+ *
+ * @param [in] gamma The gamma exponent, 1.0 (the default) disables the correction while
+ * about 2.2 to 2.8 makes fades perceptually linear.
+ */
+void WS2812::setGamma(float gamma) {
+	for (uint16_t value = 0; value < 256; value++) {
+		this->gammaTable[value] = (uint16_t) (powf(value / 255.0f, gamma) * 65535 + 0.5f);
+	}
+	buildLevelTable();
+} // setGamma
+
+
+/**
+ * @brief Enable or disable temporal dithering.
+ *
+ * With dithering, the fraction of the channel levels lost to 8 bits, which becomes large at low
+ * brightness or with gamma correction, is spread over the following frames.  This only works
+ * if frames are shown continuously, 60 times a second or more, and every frame is then fully
+ * encoded.
+ *
+ * @param [in] enabled Whether the frames are dithered.
+ */
+void WS2812::setDithering(bool enabled) {
+	if (enabled == (this->ditherError != nullptr)) {
+		return;
+	}
+	if (enabled) {
+		size_t size = this->pixelCount * this->channelCount;
+		this->ditherError = (uint8_t*) allocate("Dithering errors", size, false);
+		memset(this->ditherError, 0, size);
+	} else {
+		heap_caps_free(this->ditherError);
+		this->ditherError = nullptr;
+		// The buffers still hold dithered frames.
+		markDirty(0, this->pixelCount);
+	}
+} // setDithering
+
+
+/**
+ * @brief Build the table of the levels sent for each channel value.
+ *
+ * The gamma corrected values are kept with 16 bits of precision so that the brightness
+ * and power limiting scaling only rounds once.  The dithered levels keep 8 fractional bits, up to 255 << 8.
+ */
+void WS2812::buildLevelTable() {
+	// Brightness and power limiting scale, over 16 bits.
+	const uint32_t scale = this->brightness * this->powerScale;
+	for (uint16_t value = 0; value < 256; value++) {
+		this->levelTable[value] = ((uint64_t) this->gammaTable[value] * scale + 65535 * 128) / (65535 * 256);
+		this->ditherLevelTable[value] = ((uint64_t) this->gammaTable[value] * scale + 32767) / 65535;
+	}
+	markDirty(0, this->pixelCount);
+} // buildLevelTable
+
+
+/**
+ * @brief Resolve a color order into the byte offset of each channel within a pixel_t.
+ *
+ * See setColorOrder() for the format of the order.
+ *
+ * @param [in] colorOrder The color order, for example "GRB".
+ * @param [out] offsets The byte offsets, in wire order.  Left untouched if the order is invalid.
+ * @param [in] channelCount The number of channels of the order, 3 or 4.  Defaults to 3.
+ * @return True if the order names each channel once, 'W' only with 4 channels.
+ */
+bool WS2812::parseColorOrder(const char* colorOrder, uint8_t* offsets, uint8_t channelCount) {
+	if (colorOrder == nullptr || strlen(colorOrder) != channelCount) {
+		return false;
+	}
+	int channelOffsets[4];
+	uint8_t seen = 0;
+	for (uint8_t i = 0; i < channelCount; i++) {
+		channelOffsets[i] = getChannelOffsetByType(colorOrder[i]);
+		if (channelOffsets[i] < 0 || (seen & (1 << channelOffsets[i])) != 0) {
+			return false;
+		}
+		seen |= 1 << channelOffsets[i];
+	}
+	// Only RGBW LEDs have a white channel to send.
+	if (channelCount != 4 && (seen & (1 << offsetof(pixel_t, white))) != 0) {
+		return false;
+	}
+	for (uint8_t i = 0; i < channelCount; i++) {
+		offsets[i] = (uint8_t) channelOffsets[i];
+	}
+	return true;
+} // parseColorOrder
+
+
 /**
  * @brief Set the given pixel to the specified color.
  *
@@ -209,9 +1373,29 @@ void WS2812::setColorOrder(char* colorOrder) {
  */
 void WS2812::setPixel(uint16_t index, uint8_t red, uint8_t green, uint8_t blue) {
 	assert(index < pixelCount);
-	this->pixels[index].red   = red;
-	this->pixels[index].green = green;
-	this->pixels[index].blue  = blue;
+	pixel_t pixel = { red, green, blue, 0 };
+	this->pixels[index] = toWire(pixel);
+	markDirty(index, index + 1);
+} // setPixel
+
+
+/**
+ * @brief Set the given pixel to the specified RGBW color.
+ *
+ * The white channel is only sent to RGBW LEDs.  The LEDs are not actually updated until a
+ * call to show().
+ *
+ * @param [in] index The pixel that is to have its color set.
+ * @param [in] red The amount of red in the pixel.
+ * @param [in] green The amount of green in the pixel.
+ * @param [in] blue The amount of blue in the pixel.
+ * @param [in] white The amount of white in the pixel.
+ */
+void WS2812::setPixel(uint16_t index, uint8_t red, uint8_t green, uint8_t blue, uint8_t white) {
+	assert(index < pixelCount);
+	pixel_t pixel = { red, green, blue, white };
+	this->pixels[index] = toWire(pixel);
+	markDirty(index, index + 1);
 } // setPixel
 
 
@@ -225,7 +1409,8 @@ void WS2812::setPixel(uint16_t index, uint8_t red, uint8_t green, uint8_t blue)
  */
 void WS2812::setPixel(uint16_t index, pixel_t pixel) {
 	assert(index < pixelCount);
-	this->pixels[index] = pixel;
+	this->pixels[index] = toWire(pixel);
+	markDirty(index, index + 1);
 } // setPixel
 
 
@@ -239,11 +1424,23 @@ void WS2812::setPixel(uint16_t index, pixel_t pixel) {
  */
 void WS2812::setPixel(uint16_t index, uint32_t pixel) {
 	assert(index < pixelCount);
-	this->pixels[index].red   = pixel & 0xff;
-	this->pixels[index].green = (pixel & 0xff00) >> 8;
-	this->pixels[index].blue  = (pixel & 0xff0000) >> 16;
+	pixel_t color = { (uint8_t) pixel, (uint8_t) (pixel >> 8), (uint8_t) (pixel >> 16), (uint8_t) (pixel >> 24) };
+	this->pixels[index] = toWire(color);
+	markDirty(index, index + 1);
 } // setPixel
 
+/**
+ * @brief Get the color of the given pixel.
+ *
+ * @param [in] index The pixel.
+ * @return The color last set.
+ */
+pixel_t WS2812::getPixel(uint16_t index) {
+	assert(index < pixelCount);
+	return fromWire(this->pixels[index]);
+} // getPixel
+
+
 /**
  * @brief Set the given pixel to the specified HSB color.
  *
@@ -255,62 +1452,230 @@ void WS2812::setPixel(uint16_t index, uint32_t pixel) {
  * @param [in] brightness The amount of brightness in the pixel (0-255).
  */
 void WS2812::setHSBPixel(uint16_t index, uint16_t hue, uint8_t saturation, uint8_t brightness) {
-	double sat_red;
-	double sat_green;
-	double sat_blue;
-	double ctmp_red;
-	double ctmp_green;
-	double ctmp_blue;
-	double new_red;
-	double new_green;
-	double new_blue;
-	double dSaturation = (double) saturation / 255;
-	double dBrightness = (double) brightness / 255;
-
 	assert(index < pixelCount);
+	this->pixels[index] = toWire(hsbToPixel(hue, saturation, brightness));
+	markDirty(index, index + 1);
+} // setHSBPixel
 
-	if (hue < 120) {
-		sat_red = (120 - hue) / 60.0;
-		sat_green = hue / 60.0;
-		sat_blue = 0;
-	} else if (hue < 240) {
-		sat_red = 0;
-		sat_green = (240 - hue) / 60.0;
-		sat_blue = (hue - 120) / 60.0;
-	} else {
-		sat_red = (hue - 240) / 60.0;
-		sat_green = 0;
-		sat_blue = (360 - hue) / 60.0;
+
+/**
+ * @brief Set all the pixels to the specified color.
+ *
+ * The LEDs are not actually updated until a call to show().  The color is only encoded once
+ * for the whole strip.
+ *
+ * @param [in] pixel The color value of the pixels.
+ */
+void WS2812::fill(pixel_t pixel) {
+	fillRange(0, this->pixelCount, pixel);
+} // fill
+
+
+/**
+ * @brief Set a range of pixels to the specified color.
+ *
+ * The LEDs are not actually updated until a call to show().  The color is only encoded once
+ * for the whole range.
+ *
+ * @param [in] from The first pixel to set.
+ * @param [in] to The pixel following the last one to set.
+ * @param [in] pixel The color value of the pixels.
+ */
+void WS2812::fillRange(uint16_t from, uint16_t to, pixel_t pixel) {
+	assert(from <= to && to <= pixelCount);
+	if (from == to) {
+		return;
+	}
+	const uint32_t word = toWire(pixel);
+	for (uint16_t i = from; i < to; i++) {
+		this->pixels[i] = word;
 	}
+	markDirty(from, to);
+} // fillRange
 
-	if (sat_red > 1.0) {
-		sat_red = 1.0;
+
+/**
+ * @brief Set the first pixels from an array of colors.
+ *
+ * The LEDs are not actually updated until a call to show().
+ *
+ * @param [in] pixels The color values of the pixels.
+ * @param [in] count The number of pixels to set.
+ */
+void WS2812::copyFrom(const pixel_t* pixels, uint16_t count) {
+	assert(count <= pixelCount);
+	for (uint16_t i = 0; i < count; i++) {
+		this->pixels[i] = toWire(pixels[i]);
 	}
-	if (sat_green > 1.0) {
-		sat_green = 1.0;
+	markDirty(0, count);
+} // copyFrom
+
+
+/**
+ * @brief Set the first pixels from bytes already in the order of the wire.
+ *
+ * Each pixel takes getChannelCount() bytes, in the order set by setColorOrder(), so that a frame
+ * received from the network can be stored without any color conversion.  The LEDs are not actually
+ * updated until a call to show().
+ *
+ * @param [in] bytes The wire ordered channels of the pixels.
+ * @param [in] count The number of pixels to set.
+ */
+void WS2812::copyWireFrom(const uint8_t* bytes, uint16_t count) {
+	assert(count <= pixelCount);
+	if (this->channelCount == 4) {
+		for (uint16_t i = 0; i < count; i++, bytes += 4) {
+			this->pixels[i] = bytes[0] | bytes[1] << 8 | bytes[2] << 16 | (uint32_t) bytes[3] << 24;
+		}
+	} else {
+		for (uint16_t i = 0; i < count; i++, bytes += 3) {
+			this->pixels[i] = bytes[0] | bytes[1] << 8 | bytes[2] << 16;
+		}
 	}
-	if (sat_blue > 1.0) {
-		sat_blue = 1.0;
+	markDirty(0, count);
+} // copyWireFrom
+
+
+/**
+ * @brief Blend a range of pixels towards the specified color.
+ *
+ * The pixels are blended a word at a time, two channels per multiplication, their 16-bit lanes
+ * never carrying into each other.  The LEDs are not actually updated until a call to show().
+ *
+ * @param [in] from The first pixel to blend.
+ * @param [in] to The pixel following the last one to blend.
+ * @param [in] pixel The color to blend towards.
+ * @param [in] amount The amount of the color, from 0 (pixels unchanged) to 255 (pixels set to it).
+ */
+void WS2812::blendRange(uint16_t from, uint16_t to, pixel_t pixel, uint8_t amount) {
+	assert(from <= to && to <= pixelCount);
+	const uint32_t target     = toWire(pixel);
+	const uint32_t weight     = amount + (amount >> 7); // 0 to 256.
+	const uint32_t keep       = 256 - weight;
+	const uint32_t targetEven = (target & 0x00ff00ff) * weight;
+	const uint32_t targetOdd  = ((target >> 8) & 0x00ff00ff) * weight;
+	for (uint16_t i = from; i < to; i++) {
+		const uint32_t word = this->pixels[i];
+		const uint32_t even = (((word & 0x00ff00ff) * keep + targetEven) >> 8) & 0x00ff00ff;
+		const uint32_t odd  = (((word >> 8) & 0x00ff00ff) * keep + targetOdd) & 0xff00ff00;
+		this->pixels[i] = even | odd;
 	}
+	markDirty(from, to);
+} // blendRange
+
+
+/**
+ * @brief Convert an HSB color to a pixel color.
+ *
+ * @param [in] hue The amount of hue in the pixel (0-360).
+ * @param [in] saturation The amount of saturation in the pixel (0-255).
+ * @param [in] brightness The amount of brightness in the pixel (0-255).
+ * @return The corresponding RGB pixel.
+ */
+pixel_t WS2812::hsbToPixel(uint16_t hue, uint8_t saturation, uint8_t brightness) {
+	uint8_t levels[3];
+	getHueLevels(hue, levels);
+	pixel_t pixel;
+	pixel.red   = getHSBChannel(levels[0], saturation, brightness);
+	pixel.green = getHSBChannel(levels[1], saturation, brightness);
+	pixel.blue  = getHSBChannel(levels[2], saturation, brightness);
+	pixel.white = 0;
+	return pixel;
+} // hsbToPixel
 
-	ctmp_red = 2 * dSaturation * sat_red + (1 - dSaturation);
-	ctmp_green = 2 * dSaturation * sat_green + (1 - dSaturation);
-	ctmp_blue = 2 * dSaturation * sat_blue + (1 - dSaturation);
 
-	if (dBrightness < 0.5) {
-		new_red = dBrightness * ctmp_red;
-		new_green = dBrightness * ctmp_green;
-		new_blue = dBrightness * ctmp_blue;
+/**
+ * @brief Get the red, green and blue hue levels of an HSB hue.
+ *
+ * A level is the share of a channel in the hue, in sixtieths of a degree range: each channel
+ * fades in over 60 degrees, stays at 60 for 60 degrees and then fades out.
+ *
+ * @param [in] hue The hue (0-360), larger values wrap around.
+ * @param [out] pLevels The red, green and blue levels (0-60).
+ */
+void WS2812::getHueLevels(uint16_t hue, uint8_t* pLevels) {
+	hue %= 360;
+	uint16_t red;
+	uint16_t green;
+	uint16_t blue;
+	if (hue < 120) {
+		red   = 120 - hue;
+		green = hue;
+		blue  = 0;
+	} else if (hue < 240) {
+		red   = 0;
+		green = 240 - hue;
+		blue  = hue - 120;
 	} else {
-		new_red = (1 - dBrightness) * ctmp_red + 2 * dBrightness - 1;
-		new_green = (1 - dBrightness) * ctmp_green + 2 * dBrightness - 1;
-		new_blue = (1 - dBrightness) * ctmp_blue + 2 * dBrightness - 1;
+		red   = hue - 240;
+		green = 0;
+		blue  = 360 - hue;
 	}
+	pLevels[0] = red < 60 ? red : 60;
+	pLevels[1] = green < 60 ? green : 60;
+	pLevels[2] = blue < 60 ? blue : 60;
+} // getHueLevels
 
-	this->pixels[index].red   = (uint8_t)(new_red * 255);
-	this->pixels[index].green = (uint8_t)(new_green * 255);
-	this->pixels[index].blue  = (uint8_t)(new_blue * 255);
-} // setHSBPixel
+
+/**
+ * @brief Get the value of a channel from its hue level, the saturation and the brightness.
+ *
+ * This is the HSL lightness blend in integer arithmetic, scaled by 255 * 60 * 255 so that
+ * no intermediate value is lost to rounding: the channel saturates towards the hue level and
+ * the brightness fades it towards black below half and towards white above half.
+ *
+ * @param [in] level The hue level of the channel (0-60).
+ * @param [in] saturation The amount of saturation (0-255).
+ * @param [in] brightness The amount of brightness (0-255).
+ * @return The channel value.
+ */
+uint8_t WS2812::getHSBChannel(uint8_t level, uint8_t saturation, uint8_t brightness) {
+	// Saturated channel value, scaled by 255 * 60 (up to twice that).
+	const uint32_t saturated = 2 * saturation * level + (255 - saturation) * 60;
+	if (brightness < 128) {
+		return brightness * saturated / (255 * 60);
+	}
+	return ((255 - brightness) * saturated + (2 * brightness - 255) * (255 * 60)) / (255 * 60);
+} // getHSBChannel
+
+
+/**
+ * @brief Set a range of pixels to a sweep of HSB hues.
+ *
+ * The hue goes linearly from hueFrom on the first pixel towards hueTo, which would be the hue
+ * of the pixel following the range, so that a 0 to 360 sweep draws a full rainbow.  Hues
+ * larger than 360 wrap around.  The saturation and brightness are shared by the whole range,
+ * the channel values are computed once for each of the 61 hue levels and looked up per pixel.
+ * The LEDs are not actually updated until a call to show().
+ *
+ * @param [in] from The first pixel to set.
+ * @param [in] to The pixel following the last one to set.
+ * @param [in] hueFrom The hue of the first pixel.
+ * @param [in] hueTo The hue following the last pixel.
+ * @param [in] saturation The amount of saturation in the pixels (0-255).
+ * @param [in] brightness The amount of brightness in the pixels (0-255).
+ */
+void WS2812::setHSBRange(uint16_t from, uint16_t to, uint16_t hueFrom, uint16_t hueTo, uint8_t saturation,
+		uint8_t brightness) {
+	assert(from <= to && to <= pixelCount);
+	if (from == to) {
+		return;
+	}
+	uint8_t channels[61];
+	for (uint8_t level = 0; level <= 60; level++) {
+		channels[level] = getHSBChannel(level, saturation, brightness);
+	}
+
+	const uint16_t count = to - from;
+	const int32_t  span  = (int32_t) hueTo - hueFrom;
+	for (uint16_t i = 0; i < count; i++) {
+		uint8_t levels[3];
+		getHueLevels(hueFrom + span * i / count, levels);
+		pixel_t pixel = { channels[levels[0]], channels[levels[1]], channels[levels[2]], 0 };
+		this->pixels[from + i] = toWire(pixel);
+	}
+	markDirty(from, to);
+} // setHSBRange
 
 
 /**
@@ -320,11 +1685,8 @@ void WS2812::setHSBPixel(uint16_t index, uint16_t hue, uint8_t saturation, uint8
  * The LEDs are not actually updated until a call to show().
  */
 void WS2812::clear() {
-	for (uint16_t i = 0; i < this->pixelCount; i++) {
-		this->pixels[i].red   = 0;
-		this->pixels[i].green = 0;
-		this->pixels[i].blue  = 0;
-	}
+	memset(this->pixels, 0, this->pixelCount * sizeof(uint32_t));
+	markDirty(0, this->pixelCount);
 } // clear
 
 
@@ -332,6 +1694,21 @@ void WS2812::clear() {
  * @brief Class instance destructor.
  */
 WS2812::~WS2812() {
-	delete this->items;
-	delete this->pixels;
+	waitShowComplete(portMAX_DELAY);
+	if (this->output == WS2812_OUTPUT_SPI) {
+		spi_bus_remove_device(this->spiDevice);
+		spi_bus_free(this->spiHost);
+	} else if (this->output != WS2812_OUTPUT_I2S) {
+		s_channelStrips[this->channel] = nullptr;
+		rmt_driver_uninstall(this->channel);
+	}
+	heap_caps_free(this->items[0]);
+	heap_caps_free(this->items[1]);
+	heap_caps_free(this->wireBytes[0]);
+	heap_caps_free(this->wireBytes[1]);
+	heap_caps_free(this->spiBytes[0]);
+	heap_caps_free(this->spiBytes[1]);
+	heap_caps_free(this->spiDmaBytes);
+	heap_caps_free(this->pixels);
+	heap_caps_free(this->ditherError);
 } // ~WS2812()
@@ -5,6 +5,9 @@
 #include <stdint.h>
 #include <driver/rmt.h>
 #include <driver/gpio.h>
+#include <driver/spi_master.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 
 /**
  * @brief A data type representing the color of a pixel.
@@ -22,9 +25,123 @@ typedef struct {
 	 * @brief The blue component of the pixel.
 	 */
 	uint8_t blue;
+	/**
+	 * @brief The white component of the pixel, only sent to RGBW LEDs.
+	 */
+	uint8_t white;
 } pixel_t;
 
 
+/**
+ * @brief The type of LEDs driven, which sets their bit timings and channels.
+ */
+typedef enum {
+	/**
+	 * @brief WS2812 and WS2812B, RGB.
+	 */
+	WS2812_TYPE_WS2812,
+	/**
+	 * @brief WS2811 in high speed (800kHz) mode, RGB.
+	 */
+	WS2812_TYPE_WS2811,
+	/**
+	 * @brief WS2813 and WS2815, RGB.
+	 */
+	WS2812_TYPE_WS2813,
+	/**
+	 * @brief SK6812, RGB.
+	 */
+	WS2812_TYPE_SK6812,
+	/**
+	 * @brief SK6812 RGBW, with a fourth white channel.
+	 */
+	WS2812_TYPE_SK6812_RGBW
+} ws2812_type_t;
+
+
+/**
+ * @brief How the pixel data is sent to the LEDs.
+ */
+typedef enum {
+	/**
+	 * @brief The whole frame is encoded into RMT items before being sent, 96 bytes per pixel
+	 * (128 for RGBW pixels).
+	 */
+	WS2812_OUTPUT_RMT,
+	/**
+	 * @brief Only the wire ordered pixel bytes are kept, 3 bytes per pixel (4 for RGBW pixels),
+	 * and are translated into RMT items as the RMT memory drains.
+	 */
+	WS2812_OUTPUT_RMT_STREAM,
+	/**
+	 * @brief Each bit is encoded as 3 SPI bits, 9 bytes per pixel, or as 4 SPI bits for the WS2811
+	 * and SK6812, 12 bytes per pixel (16 for RGBW pixels), and sent by the SPI peripheral through
+	 * DMA.  The timings do not depend on the interrupt latency.
+	 */
+	WS2812_OUTPUT_SPI,
+	/**
+	 * @brief Only the wire ordered pixel bytes are kept, as for WS2812_OUTPUT_RMT_STREAM, and are
+	 * sent by the WS2812I2S owning the strip, along with the strips of its other pins.  The strip
+	 * does not drive any pin itself.
+	 */
+	WS2812_OUTPUT_I2S
+} ws2812_output_t;
+
+
+/**
+ * @brief Where the buffers of a strip are allocated.
+ */
+typedef enum {
+	/**
+	 * @brief All the buffers are in internal RAM.
+	 */
+	WS2812_PLACEMENT_INTERNAL,
+	/**
+	 * @brief The pixels and the encoded frames are in PSRAM, only the buffer read by SPI DMA
+	 * stays in internal RAM.  For very large strips on modules with PSRAM.
+	 */
+	WS2812_PLACEMENT_SPIRAM
+} ws2812_placement_t;
+
+
+/**
+ * @brief Number of buckets of the encode time histogram of ws2812_stats_t.
+ */
+#define WS2812_STATS_BUCKETS 8
+
+
+/**
+ * @brief Timings of the frames shown by a strip, in us.
+ *
+ * The counters are updated without locking, each by a single writer, and can be read at any
+ * time: a copy may mix two successive frames, but each value is consistent.
+ */
+typedef struct {
+	/**
+	 * @brief The number of frames shown.
+	 */
+	uint32_t frames;
+	/**
+	 * @brief The number of frames that had to wait for the previous one to be sent.
+	 */
+	uint32_t stalledFrames;
+	uint32_t lastEncodeUs;
+	uint32_t maxEncodeUs;
+	uint32_t lastTransmitUs;
+	uint32_t maxTransmitUs;
+	/**
+	 * @brief Time between the starts of the last two frames sent.
+	 */
+	uint32_t lastIntervalUs;
+	uint32_t maxIntervalUs;
+	/**
+	 * @brief Number of frames by encode time: bucket 0 counts frames encoded in less than 64us,
+	 * bucket i in less than 2^(i + 6)us, and the last one all the slower frames.
+	 */
+	uint32_t encodeHistogram[WS2812_STATS_BUCKETS];
+} ws2812_stats_t;
+
+
 /**
  * @brief Driver for WS2812/NeoPixel data.
  *
@@ -48,22 +165,123 @@ typedef struct {
  */
 class WS2812 {
 public:
-	WS2812(gpio_num_t gpioNum, uint16_t pixelCount, int channel = RMT_CHANNEL_0);
+	WS2812(gpio_num_t gpioNum, uint16_t pixelCount, int channel = RMT_CHANNEL_0, ws2812_output_t output = WS2812_OUTPUT_RMT,
+			uint8_t memBlocks = 0, ws2812_type_t type = WS2812_TYPE_WS2812,
+			ws2812_placement_t placement = WS2812_PLACEMENT_INTERNAL);
 	void show();
+	void showAsync();
+	bool waitShowComplete(TickType_t waitTicks = portMAX_DELAY);
+	void setShowCompleteTask(TaskHandle_t task);
 	void setColorOrder(char* order);
+	void setWhiteExtraction(bool enabled);
+	ws2812_type_t getType();
+	uint8_t getChannelCount();
+	void setBrightness(uint8_t brightness);
+	uint8_t getBrightness();
+	void setGamma(float gamma);
+	void setDithering(bool enabled);
+	void setPowerLimit(uint32_t milliamps);
+	void setChannelCurrents(uint8_t red, uint8_t green, uint8_t blue, uint8_t white);
+	uint16_t getPowerScale();
+	uint32_t getEstimatedCurrent();
 	void setPixel(uint16_t index, uint8_t red, uint8_t green, uint8_t blue);
+	void setPixel(uint16_t index, uint8_t red, uint8_t green, uint8_t blue, uint8_t white);
 	void setPixel(uint16_t index, pixel_t pixel);
 	void setPixel(uint16_t index, uint32_t pixel);
+	pixel_t getPixel(uint16_t index);
 	void setHSBPixel(uint16_t index, uint16_t hue, uint8_t saturation, uint8_t brightness);
+	void setHSBRange(uint16_t from, uint16_t to, uint16_t hueFrom, uint16_t hueTo, uint8_t saturation, uint8_t brightness);
+	void fill(pixel_t pixel);
+	void fillRange(uint16_t from, uint16_t to, pixel_t pixel);
+	void copyFrom(const pixel_t* pixels, uint16_t count);
+	void copyWireFrom(const uint8_t* bytes, uint16_t count);
+	void blendRange(uint16_t from, uint16_t to, pixel_t pixel, uint8_t amount);
 	void clear();
+	uint16_t getEncodedPixelCount();
+	uint32_t getTotalEncodedPixelCount();
+	uint32_t getFrameCount();
+	void getStats(ws2812_stats_t* pStats);
+	void resetStats();
 	virtual ~WS2812();
 
+	static bool parseColorOrder(const char* colorOrder, uint8_t* offsets, uint8_t channelCount = 3);
+	static pixel_t hsbToPixel(uint16_t hue, uint8_t saturation, uint8_t brightness);
+
 private:
-	char*          colorOrder;
+	friend class WS2812Parallel;
+	friend class WS2812I2S;
+
+	void initRMT(gpio_num_t dinPin, uint8_t memBlocks);
+	void initSPI(gpio_num_t dinPin, spi_host_device_t host);
+	void buildItemTable();
+	void buildLevelTable();
+	void* allocate(const char* name, size_t size, bool dma);
+	void allocateBuffer(uint8_t buffer);
+	void markDirty(uint16_t from, uint16_t to);
+	uint16_t getRunLength(uint16_t from, uint16_t to);
+	static void getHueLevels(uint16_t hue, uint8_t* pLevels);
+	static uint8_t getHSBChannel(uint8_t level, uint8_t saturation, uint8_t brightness);
+	uint32_t toWire(pixel_t pixel);
+	pixel_t fromWire(uint32_t word);
+	void getWireValues(uint32_t pixel, uint8_t* pValues);
+	size_t getEncodedPixelSize();
+	size_t getSPIFrameSize();
+	uint8_t* encodePixel(uint8_t buffer, uint16_t index, const uint8_t* pLevels);
+	void encode(uint8_t buffer);
+	void encodeRange(uint8_t buffer, uint16_t from, uint16_t to, uint32_t* pSums);
+	void encodeDithered(uint8_t buffer, uint32_t* pSums);
+	void rewindDithering();
+	bool limitPower(const uint32_t* pSums);
+	void transmit(uint8_t buffer, bool wait);
+	uint8_t prepareAsync();
+	void startAsync(uint8_t buffer);
+	void notifyShowComplete();
+	static void txEndCallback(rmt_channel_t channel, void* arg);
+	static void spiPostCallback(spi_transaction_t* transaction);
+	static sample_to_rmt_t getTranslator(rmt_channel_t channel);
+	template<int CHANNEL>
+	static void translate(const void* src, rmt_item32_t* dest, size_t srcSize, size_t wantedNum,
+			size_t* translatedSize, size_t* itemNum);
+
 	uint16_t       pixelCount;
 	rmt_channel_t  channel;
-	rmt_item32_t*  items;
-	pixel_t*       pixels;
+	ws2812_output_t output;
+	ws2812_type_t  type;
+	ws2812_placement_t placement;
+	uint8_t        channelCount;    // 3 for RGB LEDs, 4 for RGBW LEDs.
+	uint8_t        slotsPerBit;     // SPI and I2S slots of each bit, 3 or 4 depending on the type.
+	bool           whiteExtraction;
+	rmt_item32_t*  items[2];        // Double buffered RMT items, the second one is used by showAsync().
+	uint8_t*       wireBytes[2];    // Double buffered wire ordered pixel bytes, for WS2812_OUTPUT_RMT_STREAM.
+	uint8_t*       spiBytes[2];     // Double buffered SPI data, for WS2812_OUTPUT_SPI.
+	uint8_t*       spiDmaBytes;     // SPI data on the wire, when spiBytes are in PSRAM.
+	spi_host_device_t   spiHost;
+	spi_device_handle_t spiDevice;
+	spi_transaction_t   spiTransactions[2];
+	bool           spiPending;      // Whether a SPI transaction result has not been collected yet.
+	uint8_t        lastBuffer;      // Index of the output buffer last sent.
+	uint16_t       dirtyFrom[2];    // First pixel changed since each output buffer was encoded.
+	uint16_t       dirtyTo[2];      // Pixel following the last one changed since each output buffer was encoded.
+	uint16_t       encodedPixels;   // Pixels encoded by the last show operation.
+	uint32_t       totalEncodedPixels;
+	uint32_t       frameCount;
+	ws2812_stats_t stats;
+	int64_t        transmitStart;   // Time at which the last frame started to be sent, in us.
+	TaskHandle_t   notifyTask;      // Task notified when a frame has been sent.
+	uint32_t*      pixels;          // One word per pixel, in wire order from the low byte.
+	uint8_t        colorOffsets[4]; // Byte offset within pixel_t of each channel, in wire order.
+	uint8_t        wireShifts[4];   // Shift of each channel within the pixel words, by offset within pixel_t.
+	uint32_t       colorMask;       // Low bit of the red, green and blue channels in the pixel words.
+	uint32_t       itemTable[16][4]; // RMT item words for each nibble value, MSB first.
+	uint8_t        brightness;
+	uint16_t       gammaTable[256];  // Gamma corrected value of each channel value, over 16 bits.
+	uint8_t        levelTable[256];  // Level sent for each channel value, gamma corrected and scaled.
+	uint16_t       ditherLevelTable[256]; // Same as levelTable with 8 fractional bits, for dithering.
+	uint8_t*       ditherError;      // Fractional level carried over by each channel, when dithering.
+	uint32_t       powerLimit;       // Maximum current in mA, 0 when not limited.
+	uint16_t       powerScale;       // Scale applied by the power limit, in 1/256.
+	uint32_t       estimatedCurrent; // Current drawn by the last frame, in mA.
+	uint8_t        channelCurrents[4]; // Current of each channel at full level in mA, by offset within pixel_t.
 
 };
 
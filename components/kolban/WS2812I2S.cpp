@@ -0,0 +1,524 @@
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <driver/gpio.h>
+#include <driver/periph_ctrl.h>
+#include <rom/gpio.h>
+#include <soc/gpio_sig_map.h>
+#include <soc/i2s_reg.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "sdkconfig.h"
+#include "BitTranspose.h"
+#include "WS2812I2S.h"
+
+static const char* LOG_TAG = "WS2812I2S";
+
+/*
+ * Each WS2812 bit is sent as a high slot, a slot holding the bit value, then low slots, as many
+ * as the LED type takes, see WS2812::slotsPerBit.  3 slots of ~417ns give 0.42us high for a "0"
+ * and 0.83us for a "1", within the WS2812 and WS2813 tolerances.  The WS2811 and SK6812 allow
+ * at most 0.75us for a "1", they take 4 slots of ~313ns, for 0.31us and 0.63us high times.
+ */
+
+/*
+ * Bits of low slots sent after the pixels to latch the frame.  300us also covers the longer
+ * reset time of the WS2813.
+ */
+static const uint16_t RESET_BITS = 240;
+
+/*
+ * Slots still in the I2S FIFO, 64 words of 2 slots, when the DMA has read the last descriptor.
+ * As many low slots follow the reset ones, so that the whole reset has been clocked out by the
+ * time the FIFO drains and the frame is reported sent.
+ */
+static const uint16_t FIFO_SLOTS = 128;
+
+/*
+ * Largest payload of a DMA descriptor, the multiple of 4 just below the 4095 bytes limit.
+ */
+static const uint16_t DMA_MAX_BYTES = 4092;
+
+/*
+ * Internal function not exposed.  In 16 bits LCD mode, the two 16 bits halves of each 32 bits
+ * word read by the DMA are sent in swapped order, so slot i has to be stored at i ^ 1.
+ */
+static inline uint32_t slotIndex(uint32_t slot) {
+	return slot ^ 1;
+} // slotIndex
+
+
+/**
+ * @brief Construct a set of strips driven by I2S.
+ *
+ * The pixels are split into segments of equal length, one for each pin, the last segment
+ * taking the remainder.  The DMA buffer holds 144 bytes for each row of pixels with 3 slots per
+ * bit, 192 with 4 slots and 256 for RGBW pixels, whatever the number of pins, plus the reset
+ * slots.  The pixels themselves are kept
+ * by a WS2812, with 3 or 4 bytes per pixel for the levels sent.
+ *
+ * The bits are sent as 3 slots of ~417ns, or 4 slots of ~313ns for the WS2811 and SK6812, as
+ * with the WS2812_OUTPUT_SPI output.
+ *
+ * @param [in] dinPins The GPIO pins used to drive the data of each segment, in pixel order.
+ * @param [in] pinCount The number of pins, from 1 to 16.
+ * @param [in] pixelCount The total number of pixels.
+ * @param [in] i2sPort The I2S peripheral to use, 0 or 1.  Defaults to 1.
+ * @param [in] type The type of LEDs, which sets the number of channels and the default color
+ * order.  Defaults to WS2812_TYPE_WS2812.
+ */
+WS2812I2S::WS2812I2S(const gpio_num_t* dinPins, uint8_t pinCount, uint16_t pixelCount, int i2sPort,
+		ws2812_type_t type) {
+	assert(pinCount > 0 && pinCount <= 16);
+	assert(i2sPort == 0 || i2sPort == 1);
+
+	this->strip         = new WS2812(dinPins[0], pixelCount, 0, WS2812_OUTPUT_I2S, 0, type);
+	this->pixelCount    = pixelCount;
+	this->pinCount      = pinCount;
+	this->channelCount  = this->strip->getChannelCount();
+	this->slotsPerBit   = this->strip->slotsPerBit;
+	this->segmentLength = (pixelCount + pinCount - 1) / pinCount;
+
+	// The high and low slots never change, only the value slots are written by transpose().
+	uint32_t bits  = (uint32_t) this->segmentLength * this->channelCount * 8;
+	size_t   slots = (bits + RESET_BITS) * this->slotsPerBit + FIFO_SLOTS;
+	this->planesSize = slots * sizeof(uint16_t);
+	this->planes     = (uint16_t*) heap_caps_malloc(this->planesSize, MALLOC_CAP_DMA);
+	assert(this->planes != nullptr);
+	memset(this->planes, 0, this->planesSize);
+	uint16_t pinMask = (uint16_t) ((1 << pinCount) - 1);
+	for (uint32_t bit = 0; bit < bits; bit++) {
+		this->planes[slotIndex(bit * this->slotsPerBit)] = pinMask;
+	}
+
+	// Chain the DMA descriptors over the whole buffer.
+	this->descriptorCount = (this->planesSize + DMA_MAX_BYTES - 1) / DMA_MAX_BYTES;
+	this->descriptors     = (lldesc_t*) heap_caps_malloc(this->descriptorCount * sizeof(lldesc_t), MALLOC_CAP_DMA);
+	assert(this->descriptors != nullptr);
+	for (uint16_t i = 0; i < this->descriptorCount; i++) {
+		size_t offset = (size_t) i * DMA_MAX_BYTES;
+		size_t length = this->planesSize - offset < DMA_MAX_BYTES ? this->planesSize - offset : DMA_MAX_BYTES;
+		bool   last   = i == this->descriptorCount - 1;
+		this->descriptors[i].size   = length;
+		this->descriptors[i].length = length;
+		this->descriptors[i].offset = 0;
+		this->descriptors[i].sosf   = 0;
+		this->descriptors[i].eof    = last ? 1 : 0;
+		this->descriptors[i].owner  = 1;
+		this->descriptors[i].buf    = (uint8_t*) this->planes + offset;
+		this->descriptors[i].qe.stqe_next = last ? nullptr : &this->descriptors[i + 1];
+	}
+
+	this->frameDone = xSemaphoreCreateBinary();
+	xSemaphoreGive(this->frameDone);
+
+	// In 16 bits LCD mode, the parallel data is output on the DATA_OUT8 to DATA_OUT23 signals.
+	int firstSignal;
+	int interruptSource;
+	if (i2sPort == 0) {
+		this->i2s       = &I2S0;
+		firstSignal     = I2S0O_DATA_OUT0_IDX + 8;
+		interruptSource = ETS_I2S0_INTR_SOURCE;
+		periph_module_enable(PERIPH_I2S0_MODULE);
+	} else {
+		this->i2s       = &I2S1;
+		firstSignal     = I2S1O_DATA_OUT0_IDX + 8;
+		interruptSource = ETS_I2S1_INTR_SOURCE;
+		periph_module_enable(PERIPH_I2S1_MODULE);
+	}
+	for (uint8_t i = 0; i < pinCount; i++) {
+		gpio_pad_select_gpio(dinPins[i]);
+		gpio_set_direction(dinPins[i], GPIO_MODE_OUTPUT);
+		gpio_matrix_out(dinPins[i], firstSignal + i, false, false);
+	}
+
+	// Reset the peripheral and its DMA.
+	this->i2s->conf.tx_reset         = 1;
+	this->i2s->conf.tx_reset         = 0;
+	this->i2s->conf.tx_fifo_reset    = 1;
+	this->i2s->conf.tx_fifo_reset    = 0;
+	this->i2s->lc_conf.out_rst       = 1;
+	this->i2s->lc_conf.out_rst       = 0;
+	this->i2s->lc_conf.ahbm_rst      = 1;
+	this->i2s->lc_conf.ahbm_rst      = 0;
+	this->i2s->lc_conf.ahbm_fifo_rst = 1;
+	this->i2s->lc_conf.ahbm_fifo_rst = 0;
+
+	// 16 bits parallel LCD mode, one slot per clock.
+	this->i2s->conf.tx_msb_right  = 1;
+	this->i2s->conf.tx_mono       = 0;
+	this->i2s->conf.tx_short_sync = 0;
+	this->i2s->conf.tx_msb_shift  = 0;
+	this->i2s->conf.tx_right_first = 1;
+	this->i2s->conf.tx_slave_mod  = 0;
+	this->i2s->conf2.val            = 0;
+	this->i2s->conf2.lcd_en         = 1;
+	this->i2s->conf2.lcd_tx_wrx2_en = 0;
+	this->i2s->conf2.lcd_tx_sdx2_en = 0;
+
+	// 80MHz / (33 + 1/3) = 2.4MHz for 3 slots, 80MHz / 25 = 3.2MHz for 4 slots, for each 1.25us
+	// WS2812 bit.
+	this->i2s->sample_rate_conf.val            = 0;
+	this->i2s->sample_rate_conf.tx_bits_mod    = 16;
+	this->i2s->sample_rate_conf.tx_bck_div_num = 1;
+	this->i2s->clkm_conf.val          = 0;
+	this->i2s->clkm_conf.clka_en      = 0;
+	if (this->slotsPerBit == 4) {
+		this->i2s->clkm_conf.clkm_div_a   = 1;
+		this->i2s->clkm_conf.clkm_div_b   = 0;
+		this->i2s->clkm_conf.clkm_div_num = 25;
+	} else {
+		this->i2s->clkm_conf.clkm_div_a   = 3;
+		this->i2s->clkm_conf.clkm_div_b   = 1;
+		this->i2s->clkm_conf.clkm_div_num = 33;
+	}
+
+	// 16 bits single channel data, read from memory through DMA.
+	this->i2s->fifo_conf.val                  = 0;
+	this->i2s->fifo_conf.tx_fifo_mod_force_en = 1;
+	this->i2s->fifo_conf.tx_fifo_mod          = 1;
+	this->i2s->fifo_conf.tx_data_num          = 32;
+	this->i2s->fifo_conf.dscr_en              = 1;
+	this->i2s->conf1.val           = 0;
+	this->i2s->conf1.tx_stop_en    = 0;
+	this->i2s->conf1.tx_pcm_bypass = 1;
+	this->i2s->conf_chan.val         = 0;
+	this->i2s->conf_chan.tx_chan_mod = 1;
+	this->i2s->timing.val = 0;
+
+	this->i2s->int_ena.val = 0;
+	this->i2s->int_clr.val = 0xFFFFFFFF;
+	ESP_ERROR_CHECK(esp_intr_alloc(interruptSource, 0, interruptHandler, this, &this->interrupt));
+
+	ESP_LOGI(LOG_TAG, "I2S%d: %d pins, %d pixels per pin, %d bytes of DMA buffer in %d descriptors",
+		i2sPort, pinCount, this->segmentLength, (int) this->planesSize, this->descriptorCount);
+} // WS2812I2S
+
+
+/**
+ * @brief Called from the I2S interrupt at the end of a frame.
+ *
+ * When the DMA has read the last descriptor, the FIFO still holds the last slots of the buffer,
+ * so the transmission is only stopped once the FIFO is empty.  The outputs then stay low.
+ */
+void IRAM_ATTR WS2812I2S::interruptHandler(void* arg) {
+	WS2812I2S* strip  = (WS2812I2S*) arg;
+	uint32_t   status = strip->i2s->int_st.val;
+	strip->i2s->int_clr.val = status;
+
+	if (status & I2S_OUT_TOTAL_EOF_INT_ST) {
+		strip->i2s->int_ena.out_total_eof = 0;
+		strip->i2s->int_clr.tx_rempty     = 1;
+		strip->i2s->int_ena.tx_rempty     = 1;
+	} else if (status & I2S_TX_REMPTY_INT_ST) {
+		strip->i2s->int_ena.tx_rempty = 0;
+		strip->i2s->conf.tx_start     = 0;
+		strip->strip->notifyShowComplete();
+		BaseType_t higherPriorityTaskWoken = pdFALSE;
+		xSemaphoreGiveFromISR(strip->frameDone, &higherPriorityTaskWoken);
+		if (higherPriorityTaskWoken == pdTRUE) {
+			portYIELD_FROM_ISR();
+		}
+	}
+} // interruptHandler
+
+
+/**
+ * @brief Write the bit planes of the encoded pixels into the value slots of the DMA buffer.
+ *
+ * Pixel p of every segment is sent at the same time, so for each row of pixels and each
+ * channel, the wire ordered levels of the segments are transposed into 8 bit planes.
+ */
+void WS2812I2S::transpose() {
+	const uint8_t* levels = this->strip->wireBytes[0];
+	uint8_t  bytes[16] = { };
+	uint8_t  bytePlanes[8];
+	uint16_t wordPlanes[8];
+	uint32_t slot = 1; // The value slot of the first bit.
+
+	for (uint16_t p = 0; p < this->segmentLength; p++) {
+		for (uint8_t c = 0; c < this->channelCount; c++) {
+			uint32_t index = p;
+			for (uint8_t s = 0; s < this->pinCount; s++, index += this->segmentLength) {
+				bytes[s] = index < this->pixelCount ? levels[index * this->channelCount + c] : 0;
+			}
+			if (this->pinCount <= 8) {
+				transpose8x8(bytes, bytePlanes);
+				for (uint8_t k = 0; k < 8; k++, slot += this->slotsPerBit) {
+					this->planes[slotIndex(slot)] = bytePlanes[k];
+				}
+			} else {
+				transpose16x8(bytes, wordPlanes);
+				for (uint8_t k = 0; k < 8; k++, slot += this->slotsPerBit) {
+					this->planes[slotIndex(slot)] = wordPlanes[k];
+				}
+			}
+		}
+	}
+} // transpose
+
+
+/**
+ * @brief Start clocking out the DMA buffer from its first descriptor.
+ */
+void WS2812I2S::start() {
+	this->i2s->conf.tx_start      = 0;
+	this->i2s->conf.tx_reset      = 1;
+	this->i2s->conf.tx_reset      = 0;
+	this->i2s->conf.tx_fifo_reset = 1;
+	this->i2s->conf.tx_fifo_reset = 0;
+	this->i2s->lc_conf.out_rst    = 1;
+	this->i2s->lc_conf.out_rst    = 0;
+
+	this->i2s->out_link.addr  = (uint32_t) (uintptr_t) &this->descriptors[0];
+	this->i2s->int_clr.val    = 0xFFFFFFFF;
+	this->i2s->int_ena.out_total_eof = 1;
+	this->i2s->out_link.start = 1;
+	this->i2s->conf.tx_start  = 1;
+} // start
+
+
+/**
+ * @brief Show the current pixel data on all the pins.
+ *
+ * The call only returns once the whole frame has been sent.
+ */
+void WS2812I2S::show() {
+	showAsync();
+	waitShowComplete();
+} // show
+
+
+/**
+ * @brief Show the current pixel data on all the pins without waiting for it to be sent.
+ *
+ * The levels of the changed pixels are encoded while the previous frame is still being sent,
+ * but there is a single DMA buffer, so the call then waits for that frame to be sent before
+ * writing the bit planes.
+ */
+void WS2812I2S::showAsync() {
+	this->strip->encode(0);
+	if (xSemaphoreTake(this->frameDone, 0) != pdTRUE) {
+		this->strip->stats.stalledFrames++;
+		xSemaphoreTake(this->frameDone, portMAX_DELAY);
+	}
+	transpose();
+	// Only records the frame timings, the WS2812_OUTPUT_I2S output does not send anything.
+	this->strip->transmit(0, false);
+	start();
+} // showAsync
+
+
+/**
+ * @brief Wait for the last frame to be sent.
+ *
+ * @param [in] waitTicks The maximum number of ticks to wait.
+ * @return True if the frame has been sent, false on timeout.
+ */
+bool WS2812I2S::waitShowComplete(TickType_t waitTicks) {
+	if (xSemaphoreTake(this->frameDone, waitTicks) != pdTRUE) {
+		return false;
+	}
+	xSemaphoreGive(this->frameDone);
+	return true;
+} // waitShowComplete
+
+
+/**
+ * @brief Set the task to notify each time a frame has been sent.
+ *
+ * See WS2812::setShowCompleteTask().
+ */
+void WS2812I2S::setShowCompleteTask(TaskHandle_t task) {
+	this->strip->setShowCompleteTask(task);
+} // setShowCompleteTask
+
+
+/**
+ * @brief Set the color order of data sent to the LEDs.
+ *
+ * See WS2812::setColorOrder().
+ */
+void WS2812I2S::setColorOrder(char* colorOrder) {
+	this->strip->setColorOrder(colorOrder);
+} // setColorOrder
+
+
+/**
+ * @brief Set whether the white of RGB colors is sent to the white channel of RGBW LEDs.
+ *
+ * See WS2812::setWhiteExtraction().
+ */
+void WS2812I2S::setWhiteExtraction(bool enabled) {
+	this->strip->setWhiteExtraction(enabled);
+} // setWhiteExtraction
+
+
+/**
+ * @brief Get the number of channels of the LEDs, 3 or 4.
+ */
+uint8_t WS2812I2S::getChannelCount() {
+	return this->channelCount;
+} // getChannelCount
+
+
+/**
+ * @brief Set the brightness applied to all the pixels when they are sent.
+ *
+ * See WS2812::setBrightness().
+ */
+void WS2812I2S::setBrightness(uint8_t brightness) {
+	this->strip->setBrightness(brightness);
+} // setBrightness
+
+
+/**
+ * @brief Get the brightness applied to all the pixels.
+ */
+uint8_t WS2812I2S::getBrightness() {
+	return this->strip->getBrightness();
+} // getBrightness
+
+
+/**
+ * @brief Set the gamma correction applied to the channels when they are sent.
+ *
+ * See WS2812::setGamma().
+ */
+void WS2812I2S::setGamma(float gamma) {
+	this->strip->setGamma(gamma);
+} // setGamma
+
+
+/**
+ * @brief Enable or disable temporal dithering.
+ *
+ * See WS2812::setDithering().
+ */
+void WS2812I2S::setDithering(bool enabled) {
+	this->strip->setDithering(enabled);
+} // setDithering
+
+
+/**
+ * @brief Limit the current drawn by all the strips together.
+ *
+ * See WS2812::setPowerLimit().
+ */
+void WS2812I2S::setPowerLimit(uint32_t milliamps) {
+	this->strip->setPowerLimit(milliamps);
+} // setPowerLimit
+
+
+/**
+ * @brief Set the given pixel to the specified color.
+ *
+ * @param [in] index The pixel that is to have its color set.
+ * @param [in] red The amount of red in the pixel.
+ * @param [in] green The amount of green in the pixel.
+ * @param [in] blue The amount of blue in the pixel.
+ */
+void WS2812I2S::setPixel(uint16_t index, uint8_t red, uint8_t green, uint8_t blue) {
+	this->strip->setPixel(index, red, green, blue);
+} // setPixel
+
+
+/**
+ * @brief Set the given pixel to the specified color, with a white level for RGBW LEDs.
+ *
+ * @param [in] index The pixel that is to have its color set.
+ * @param [in] red The amount of red in the pixel.
+ * @param [in] green The amount of green in the pixel.
+ * @param [in] blue The amount of blue in the pixel.
+ * @param [in] white The amount of white in the pixel.
+ */
+void WS2812I2S::setPixel(uint16_t index, uint8_t red, uint8_t green, uint8_t blue, uint8_t white) {
+	this->strip->setPixel(index, red, green, blue, white);
+} // setPixel
+
+
+/**
+ * @brief Set the given pixel to the specified color.
+ *
+ * @param [in] index The pixel that is to have its color set.
+ * @param [in] pixel The color value of the pixel.
+ */
+void WS2812I2S::setPixel(uint16_t index, pixel_t pixel) {
+	this->strip->setPixel(index, pixel);
+} // setPixel
+
+
+/**
+ * @brief Set the given pixel to the specified color.
+ *
+ * @param [in] index The pixel that is to have its color set.
+ * @param [in] pixel The color value of the pixel.
+ */
+void WS2812I2S::setPixel(uint16_t index, uint32_t pixel) {
+	this->strip->setPixel(index, pixel);
+} // setPixel
+
+
+/**
+ * @brief Get the color of the given pixel.
+ *
+ * @param [in] index The pixel.
+ * @return The color of the pixel.
+ */
+pixel_t WS2812I2S::getPixel(uint16_t index) {
+	return this->strip->getPixel(index);
+} // getPixel
+
+
+/**
+ * @brief Set the given pixel to the specified HSB color.
+ *
+ * @param [in] index The pixel that is to have its color set.
+ * @param [in] hue The amount of hue in the pixel (0-360).
+ * @param [in] saturation The amount of saturation in the pixel (0-255).
+ * @param [in] brightness The amount of brightness in the pixel (0-255).
+ */
+void WS2812I2S::setHSBPixel(uint16_t index, uint16_t hue, uint8_t saturation, uint8_t brightness) {
+	this->strip->setHSBPixel(index, hue, saturation, brightness);
+} // setHSBPixel
+
+
+/**
+ * @brief Set all the pixels to the specified color.
+ *
+ * @param [in] pixel The color of the pixels.
+ */
+void WS2812I2S::fill(pixel_t pixel) {
+	this->strip->fill(pixel);
+} // fill
+
+
+/**
+ * @brief Clear all the pixel colors.
+ */
+void WS2812I2S::clear() {
+	this->strip->clear();
+} // clear
+
+
+/**
+ * @brief Get the timings of the frames shown.
+ *
+ * See WS2812::getStats().
+ */
+void WS2812I2S::getStats(ws2812_stats_t* pStats) {
+	this->strip->getStats(pStats);
+} // getStats
+
+
+/**
+ * @brief Class instance destructor.
+ */
+WS2812I2S::~WS2812I2S() {
+	waitShowComplete();
+	esp_intr_free(this->interrupt);
+	heap_caps_free(this->descriptors);
+	heap_caps_free(this->planes);
+	vSemaphoreDelete(this->frameDone);
+	delete this->strip;
+} // ~WS2812I2S
@@ -0,0 +1,86 @@
+#ifndef MAIN_WS2812I2S_H_
+#define MAIN_WS2812I2S_H_
+#include <stdint.h>
+#include <driver/gpio.h>
+#include <esp_intr_alloc.h>
+#include <rom/lldesc.h>
+#include <soc/i2s_struct.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include "WS2812.h"
+
+/**
+ * @brief Driver for up to 16 WS2812 strips clocked out together by the I2S peripheral.
+ *
+ * The RMT peripheral only has 8 channels and needs the CPU to refill its memory while sending.
+ * In LCD mode, the I2S peripheral instead outputs 16 bits in parallel at each clock, straight
+ * from memory through DMA.  Each WS2812 bit is sent as 3 I2S slots at 2.4MHz, or 4 slots at
+ * 3.2MHz for the WS2811 and SK6812: a high slot, a slot holding the bit and low slots.  The
+ * frame is stored as bit planes: for each bit, one 16 bits word holds that bit for every strip,
+ * so the strips are refreshed together for the cost of a single one.
+ *
+ * The pixels are kept by a WS2812 using the WS2812_OUTPUT_I2S output, for one logical strip split
+ * into consecutive segments of equal length, one for each pin, as WS2812Parallel does.  The
+ * brightness, gamma, dithering, power limit, RGBW and color order of that strip therefore apply
+ * as on the other outputs: its wire ordered levels are transposed into the bit planes.
+ *
+ * @code{.cpp}
+ * gpio_num_t pins[] = { GPIO_NUM_16, GPIO_NUM_17, GPIO_NUM_18, GPIO_NUM_19 };
+ * WS2812I2S strip = WS2812I2S(
+ *   pins, 4, // Pins and pin count
+ *   1200     // Pixel count, 300 on each pin
+ * );
+ * strip.setPixel(300, 128, 0, 0); // First pixel of the second segment.
+ * strip.show();
+ * @endcode
+ */
+class WS2812I2S {
+public:
+	WS2812I2S(const gpio_num_t* dinPins, uint8_t pinCount, uint16_t pixelCount, int i2sPort = 1,
+			ws2812_type_t type = WS2812_TYPE_WS2812);
+	void show();
+	void showAsync();
+	bool waitShowComplete(TickType_t waitTicks = portMAX_DELAY);
+	void setShowCompleteTask(TaskHandle_t task);
+	void setColorOrder(char* order);
+	void setWhiteExtraction(bool enabled);
+	uint8_t getChannelCount();
+	void setBrightness(uint8_t brightness);
+	uint8_t getBrightness();
+	void setGamma(float gamma);
+	void setDithering(bool enabled);
+	void setPowerLimit(uint32_t milliamps);
+	void setPixel(uint16_t index, uint8_t red, uint8_t green, uint8_t blue);
+	void setPixel(uint16_t index, uint8_t red, uint8_t green, uint8_t blue, uint8_t white);
+	void setPixel(uint16_t index, pixel_t pixel);
+	void setPixel(uint16_t index, uint32_t pixel);
+	pixel_t getPixel(uint16_t index);
+	void setHSBPixel(uint16_t index, uint16_t hue, uint8_t saturation, uint8_t brightness);
+	void fill(pixel_t pixel);
+	void clear();
+	void getStats(ws2812_stats_t* pStats);
+	virtual ~WS2812I2S();
+
+private:
+	void transpose();
+	void start();
+	static void interruptHandler(void* arg);
+
+	WS2812*            strip;           // Pixels of all the segments, in pixel order.
+	uint16_t           pixelCount;
+	uint16_t           segmentLength;   // Pixels driven by each pin, the last one may drive less.
+	uint8_t            pinCount;
+	uint8_t            channelCount;
+	uint8_t            slotsPerBit;     // Slots of each bit, 3 at 2.4MHz or 4 at 3.2MHz.
+	i2s_dev_t*         i2s;
+	intr_handle_t      interrupt;
+	SemaphoreHandle_t  frameDone;       // Given when the whole frame has been clocked out.
+	uint16_t*          planes;          // DMA buffer, 3 or 4 slots of 16 bits for each bit of a pixel row.
+	size_t             planesSize;      // Size of the DMA buffer, in bytes.
+	lldesc_t*          descriptors;
+	uint16_t           descriptorCount;
+
+};
+
+#endif /* MAIN_WS2812I2S_H_ */
@@ -0,0 +1,186 @@
+#include <esp_log.h>
+#include <driver/rmt.h>
+#include <driver/gpio.h>
+#include <stdint.h>
+
+#include "sdkconfig.h"
+#include "WS2812Parallel.h"
+
+static const char* LOG_TAG = "WS2812Parallel";
+
+/**
+ * @brief Construct a strip split over several outputs.
+ *
+ * The pixels are split into segments of equal length, one for each pin, the last segment
+ * taking the remainder.  Output i uses RMT channel firstChannel + i * memBlocks, where
+ * memBlocks is the share of the RMT memory blocks left from firstChannel given to each output.
+ *
+ * @param [in] dinPins The GPIO pins used to drive the data of each segment, in pixel order.
+ * @param [in] pinCount The number of pins, at most 8 - firstChannel.
+ * @param [in] pixelCount The total number of pixels.
+ * @param [in] firstChannel The first RMT channel to use.  Defaults to RMT_CHANNEL_0.
+ * @param [in] output How the pixel data is handed over to RMT.  Defaults to WS2812_OUTPUT_RMT.
+ * @param [in] type The type of LEDs.  Defaults to WS2812_TYPE_WS2812.
+ */
+WS2812Parallel::WS2812Parallel(const gpio_num_t* dinPins, uint8_t pinCount, uint16_t pixelCount, int firstChannel,
+		ws2812_output_t output, ws2812_type_t type) {
+	assert(pinCount > 0 && firstChannel + pinCount <= RMT_CHANNEL_MAX);
+
+	this->pixelCount    = pixelCount;
+	this->segmentLength = (pixelCount + pinCount - 1) / pinCount;
+	if (this->segmentLength == 0) {
+		this->segmentLength = 1;
+	}
+	// Small strips may not need all the pins.
+	this->outputCount   = (pixelCount + this->segmentLength - 1) / this->segmentLength;
+	if (this->outputCount == 0) {
+		this->outputCount = 1;
+	}
+
+	uint8_t memBlocks = (RMT_CHANNEL_MAX - firstChannel) / this->outputCount;
+	this->strips  = new WS2812*[this->outputCount];
+	this->buffers = new uint8_t[this->outputCount];
+	for (uint8_t i = 0; i < this->outputCount; i++) {
+		uint16_t first = i * this->segmentLength;
+		uint16_t count = pixelCount - first < this->segmentLength ? pixelCount - first : this->segmentLength;
+		this->strips[i] = new WS2812(dinPins[i], count, firstChannel + i * memBlocks, output, memBlocks, type);
+		ESP_LOGI(LOG_TAG, "Output %d: pin %d, RMT channel %d (%d memory blocks), pixels %d to %d",
+			i, dinPins[i], firstChannel + i * memBlocks, memBlocks, first, first + count - 1);
+	}
+} // WS2812Parallel
+
+
+/**
+ * @brief Show the current pixel data on all the outputs.
+ *
+ * The call only returns once the whole frame has been sent.
+ */
+void WS2812Parallel::show() {
+	showAsync();
+	waitShowComplete();
+} // show
+
+
+/**
+ * @brief Show the current pixel data on all the outputs without waiting for it to be sent.
+ *
+ * All the segments are encoded before any of them is started, so that the outputs start
+ * together rather than one encode time apart.
+ */
+void WS2812Parallel::showAsync() {
+	for (uint8_t i = 0; i < this->outputCount; i++) {
+		this->buffers[i] = this->strips[i]->prepareAsync();
+	}
+	for (uint8_t i = 0; i < this->outputCount; i++) {
+		this->strips[i]->startAsync(this->buffers[i]);
+	}
+} // showAsync
+
+
+/**
+ * @brief Wait for the last frame to be sent on all the outputs.
+ *
+ * @param [in] waitTicks The maximum number of ticks to wait for each output.
+ * @return True if the frame has been sent, false on timeout.
+ */
+bool WS2812Parallel::waitShowComplete(TickType_t waitTicks) {
+	bool complete = true;
+	for (uint8_t i = 0; i < this->outputCount; i++) {
+		complete = this->strips[i]->waitShowComplete(waitTicks) && complete;
+	}
+	return complete;
+} // waitShowComplete
+
+
+/**
+ * @brief Set the color order of data sent to the LEDs of all the outputs.
+ *
+ * See WS2812::setColorOrder().
+ */
+void WS2812Parallel::setColorOrder(char* colorOrder) {
+	for (uint8_t i = 0; i < this->outputCount; i++) {
+		this->strips[i]->setColorOrder(colorOrder);
+	}
+} // setColorOrder
+
+
+/**
+ * @brief Set the given pixel to the specified color.
+ *
+ * @param [in] index The pixel that is to have its color set.
+ * @param [in] red The amount of red in the pixel.
+ * @param [in] green The amount of green in the pixel.
+ * @param [in] blue The amount of blue in the pixel.
+ */
+void WS2812Parallel::setPixel(uint16_t index, uint8_t red, uint8_t green, uint8_t blue) {
+	assert(index < pixelCount);
+	this->strips[index / this->segmentLength]->setPixel(index % this->segmentLength, red, green, blue);
+} // setPixel
+
+
+/**
+ * @brief Set the given pixel to the specified color.
+ *
+ * @param [in] index The pixel that is to have its color set.
+ * @param [in] pixel The color value of the pixel.
+ */
+void WS2812Parallel::setPixel(uint16_t index, pixel_t pixel) {
+	assert(index < pixelCount);
+	this->strips[index / this->segmentLength]->setPixel(index % this->segmentLength, pixel);
+} // setPixel
+
+
+/**
+ * @brief Set the given pixel to the specified color.
+ *
+ * @param [in] index The pixel that is to have its color set.
+ * @param [in] pixel The color value of the pixel.
+ */
+void WS2812Parallel::setPixel(uint16_t index, uint32_t pixel) {
+	assert(index < pixelCount);
+	this->strips[index / this->segmentLength]->setPixel(index % this->segmentLength, pixel);
+} // setPixel
+
+
+/**
+ * @brief Set the given pixel to the specified HSB color.
+ *
+ * @param [in] index The pixel that is to have its color set.
+ * @param [in] hue The amount of hue in the pixel (0-360).
+ * @param [in] saturation The amount of saturation in the pixel (0-255).
+ * @param [in] brightness The amount of brightness in the pixel (0-255).
+ */
+void WS2812Parallel::setHSBPixel(uint16_t index, uint16_t hue, uint8_t saturation, uint8_t brightness) {
+	assert(index < pixelCount);
+	this->strips[index / this->segmentLength]->setHSBPixel(index % this->segmentLength, hue, saturation, brightness);
+} // setHSBPixel
+
+
+/**
+ * @brief Clear all the pixel colors of all the outputs.
+ */
+void WS2812Parallel::clear() {
+	for (uint8_t i = 0; i < this->outputCount; i++) {
+		this->strips[i]->clear();
+	}
+} // clear
+
+
+/**
+ * @brief Get the number of outputs actually driving pixels.
+ */
+uint8_t WS2812Parallel::getOutputCount() {
+	return this->outputCount;
+} // getOutputCount
+
+
+/**
+ * @brief Class instance destructor.
+ */
+WS2812Parallel::~WS2812Parallel() {
+	for (uint8_t i = 0; i < this->outputCount; i++) {
+		delete this->strips[i];
+	}
+	delete[] this->strips;
+	delete[] this->buffers;
+} // ~WS2812Parallel
@@ -0,0 +1,53 @@
+#ifndef MAIN_WS2812PARALLEL_H_
+#define MAIN_WS2812PARALLEL_H_
+#include <stdint.h>
+#include <driver/rmt.h>
+#include <driver/gpio.h>
+
+#include "WS2812.h"
+
+/**
+ * @brief Driver for one logical WS2812 strip split over several outputs.
+ *
+ * The time needed to send a frame to WS2812s grows linearly with the number of pixels,
+ * about 30us per pixel.  This class divides one range of pixels into consecutive segments,
+ * each one wired to its own GPIO and driven by its own RMT channel.  The segments are all
+ * encoded first and then started together, so a frame takes about the time of a single
+ * segment.  The RMT memory blocks are shared evenly between the channels.
+ *
+ * @code{.cpp}
+ * gpio_num_t pins[] = { GPIO_NUM_16, GPIO_NUM_17, GPIO_NUM_18, GPIO_NUM_19 };
+ * WS2812Parallel strip = WS2812Parallel(
+ *   pins, 4, // Pins and pin count
+ *   600      // Pixel count, 150 on each pin
+ * );
+ * strip.setPixel(300, 128, 0, 0); // First pixel of the third segment.
+ * strip.show();
+ * @endcode
+ */
+class WS2812Parallel {
+public:
+	WS2812Parallel(const gpio_num_t* dinPins, uint8_t pinCount, uint16_t pixelCount, int firstChannel = RMT_CHANNEL_0,
+			ws2812_output_t output = WS2812_OUTPUT_RMT, ws2812_type_t type = WS2812_TYPE_WS2812);
+	void show();
+	void showAsync();
+	bool waitShowComplete(TickType_t waitTicks = portMAX_DELAY);
+	void setColorOrder(char* order);
+	void setPixel(uint16_t index, uint8_t red, uint8_t green, uint8_t blue);
+	void setPixel(uint16_t index, pixel_t pixel);
+	void setPixel(uint16_t index, uint32_t pixel);
+	void setHSBPixel(uint16_t index, uint16_t hue, uint8_t saturation, uint8_t brightness);
+	void clear();
+	uint8_t getOutputCount();
+	virtual ~WS2812Parallel();
+
+private:
+	uint16_t  pixelCount;
+	uint16_t  segmentLength; // Pixels driven by each output, the last one may drive less.
+	uint8_t   outputCount;
+	WS2812**  strips;        // One strip per output, in pixel order.
+	uint8_t*  buffers;       // Output buffer prepared on each strip by showAsync().
+
+};
+
+#endif /* MAIN_WS2812PARALLEL_H_ */
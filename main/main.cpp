@@ -9,6 +9,8 @@
   #include "mode_handler.h"
 #endif
 #include "module_config.h"
+#include "e131_config.h"
+#include "artnet_config.h"
 
 extern "C" {
   void app_main();
@@ -84,13 +86,10 @@ void app_main()
 
   init_strip();
 
-  last_color.red = 10;
-  last_color.green = 10;
-  last_color.blue = 10;
-  for (int i = 0; i < num_led; i++) {
-    strip->setPixel(i, last_color.red, last_color.green, last_color.blue);
-  }
+  pixel_t boot_color = { 10, 10, 10, 0 };
+  strip->fill(boot_color);
   strip->show();
+  start_strip_render();
 
   #if CONFIG_MODE_HANDLER
     initialize_mode_handler();
@@ -146,10 +145,23 @@ void launch_default_mode() {
     load_mqtt_uri_from_nvs(&mqtt_uri);
     mqtt_app_start(mqtt_uri, MAIN_MQTT_EVENT_HANDLER);
     free(mqtt_uri);
+
+#if CONFIG_E131_RECEIVER
+    start_e131();
+#endif
+#if CONFIG_ARTNET_NODE
+    start_artnet();
+#endif
   }
 }
 
 void quit_default_mode() {
+#if CONFIG_E131_RECEIVER
+  stop_e131();
+#endif
+#if CONFIG_ARTNET_NODE
+  stop_artnet();
+#endif
   clean_mqtt();
   clean_wifi();
 }
@@ -0,0 +1,78 @@
+#include <mutex>
+
+#include "dmx_harness.h"
+#include "mock.h"
+#include "module_config.h"
+
+WS2812*  strip   = nullptr;
+uint16_t num_led = 0;
+
+static std::mutex                        s_mutex;
+static std::vector<uint8_t>              s_frameBuffer;
+static bool                              s_available = true;
+static bool                              s_held      = false;
+static std::vector<std::vector<uint8_t>> s_posted;
+
+
+void initStrip(ws2812_type_t type, uint16_t count) {
+	strip   = new WS2812(GPIO_NUM_16, count, RMT_CHANNEL_0, WS2812_OUTPUT_RMT, 0, type);
+	num_led = count;
+	std::lock_guard<std::mutex> lock(s_mutex);
+	s_frameBuffer.assign(count * strip->getChannelCount(), 0);
+	s_available = true;
+	s_held      = false;
+	s_posted.clear();
+} // initStrip
+
+
+void deleteStrip() {
+	delete strip;
+	strip   = nullptr;
+	num_led = 0;
+	mock_reset();
+} // deleteStrip
+
+
+void setFrameBufferAvailable(bool available) {
+	std::lock_guard<std::mutex> lock(s_mutex);
+	s_available = available;
+} // setFrameBufferAvailable
+
+
+bool isFrameBufferHeld() {
+	std::lock_guard<std::mutex> lock(s_mutex);
+	return s_held;
+} // isFrameBufferHeld
+
+
+std::vector<std::vector<uint8_t>> takePostedFrames() {
+	std::lock_guard<std::mutex> lock(s_mutex);
+	std::vector<std::vector<uint8_t>> frames;
+	frames.swap(s_posted);
+	return frames;
+} // takePostedFrames
+
+
+uint8_t* acquire_frame_buffer(size_t* size) {
+	std::lock_guard<std::mutex> lock(s_mutex);
+	if (!s_available || s_held) {
+		*size = 0;
+		return NULL;
+	}
+	s_held = true;
+	*size  = s_frameBuffer.size();
+	return s_frameBuffer.data();
+} // acquire_frame_buffer
+
+
+void release_frame_buffer() {
+	std::lock_guard<std::mutex> lock(s_mutex);
+	s_held = false;
+} // release_frame_buffer
+
+
+void post_frame(size_t length) {
+	std::lock_guard<std::mutex> lock(s_mutex);
+	s_posted.push_back(std::vector<uint8_t>(s_frameBuffer.begin(), s_frameBuffer.begin() + length));
+	s_held = false;
+} // post_frame
@@ -0,0 +1,35 @@
+/*
+ * Stand-ins of the module functions used by the DMX receivers.
+ *
+ * The frame buffer is a single buffer, taken by the receiver from the first universe of a
+ * frame until the frame is posted or given up.  The frames posted are kept for the tests.
+ */
+#ifndef HOST_DMX_HARNESS_H_
+#define HOST_DMX_HARNESS_H_
+#include <stdint.h>
+#include <vector>
+
+#include "WS2812.h"
+
+/**
+ * @brief Create the strip the receivers map the universes to.
+ */
+void initStrip(ws2812_type_t type, uint16_t count);
+void deleteStrip();
+
+/**
+ * @brief Make the frame buffer unavailable, as while frames are disabled.
+ */
+void setFrameBufferAvailable(bool available);
+
+/**
+ * @brief Whether the receiver holds the frame buffer.
+ */
+bool isFrameBufferHeld();
+
+/**
+ * @brief The frames posted since the last call.
+ */
+std::vector<std::vector<uint8_t>> takePostedFrames();
+
+#endif
@@ -0,0 +1,74 @@
+/*
+ * Minimal test and benchmark helpers of the host harness.
+ *
+ * Each test program checks one driver or module, prints its failures and returns non zero if
+ * any check failed.  Run with --bench, it also runs its benchmarks.
+ */
+#ifndef HOST_TEST_H_
+#define HOST_TEST_H_
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+
+static int s_failures = 0;
+
+#define CHECK(condition) do {                                                 \
+		if (!(condition)) {                                                    \
+			fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+			s_failures++;                                                      \
+		}                                                                      \
+	} while (0)
+
+#define CHECK_EQUAL(expected, actual) do {                                    \
+		long long __expected = (long long) (expected);                         \
+		long long __actual   = (long long) (actual);                           \
+		if (__expected != __actual) {                                          \
+			fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, \
+				__actual, __expected);                                         \
+			s_failures++;                                                      \
+		}                                                                      \
+	} while (0)
+
+
+/**
+ * @brief Whether the benchmarks were requested on the command line.
+ */
+static inline bool isBenchmark(int argc, char** argv) {
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--bench") == 0) {
+			return true;
+		}
+	}
+	return false;
+} // isBenchmark
+
+
+/**
+ * @brief Average time of a call to a function in ns, after a first warm up call.
+ */
+template<typename Function>
+static double benchmarkNs(uint32_t iterations, Function function) {
+	function();
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < iterations; i++) {
+		function();
+	}
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / iterations;
+} // benchmarkNs
+
+
+/**
+ * @brief Report the result of a test program, to be returned from main().
+ */
+static inline int finishTest(const char* name) {
+	if (s_failures > 0) {
+		fprintf(stderr, "%s: %d checks failed\n", name, s_failures);
+		return 1;
+	}
+	printf("%s: OK\n", name);
+	return 0;
+} // finishTest
+
+#endif
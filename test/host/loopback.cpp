@@ -0,0 +1,27 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "loopback.h"
+#include "mock.h"
+
+static int s_socket = -1;
+
+
+void postDatagram(uint16_t port, const std::vector<uint8_t>& datagram) {
+	if (s_socket < 0) {
+		s_socket = socket(AF_INET, SOCK_DGRAM, 0);
+	}
+	struct sockaddr_in to = { };
+	to.sin_family      = AF_INET;
+	to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	to.sin_port        = htons(port);
+	sendto(s_socket, datagram.data(), datagram.size(), 0, (struct sockaddr*) &to, sizeof(to));
+} // postDatagram
+
+
+bool sendDatagram(uint16_t port, const std::vector<uint8_t>& datagram) {
+	uint32_t handled = mock_netconn_handled();
+	postDatagram(port, datagram);
+	return mock_netconn_wait_handled(handled + 1, 1000);
+} // sendDatagram
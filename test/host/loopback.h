@@ -0,0 +1,21 @@
+/*
+ * Sender of UDP datagrams to the network modules, over the loopback interface.
+ */
+#ifndef HOST_LOOPBACK_H_
+#define HOST_LOOPBACK_H_
+#include <stdint.h>
+#include <vector>
+
+/**
+ * @brief Send a datagram to a port of 127.0.0.1 and wait for the module to handle it.
+ *
+ * @return False if the module did not handle the datagram within a second.
+ */
+bool sendDatagram(uint16_t port, const std::vector<uint8_t>& datagram);
+
+/**
+ * @brief Send a datagram to a port of 127.0.0.1 without waiting.
+ */
+void postDatagram(uint16_t port, const std::vector<uint8_t>& datagram);
+
+#endif
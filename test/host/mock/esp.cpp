@@ -0,0 +1,119 @@
+/*
+ * Host mock of the ESP-IDF system functions: heap, timer and GPIO.
+ */
+#include <stdlib.h>
+#include <chrono>
+#include <map>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <driver/gpio.h>
+
+#include "GPIO.h"
+#include "mock.h"
+
+
+/*
+ * DMA capable memory is allocated in a 1MB aligned window, as the internal RAM of the ESP32, so
+ * that mock_dma_address() finds it back from the 20 bits addresses of the DMA registers.
+ */
+static const size_t DMA_WINDOW_SIZE = 1 << 20;
+
+static uint8_t* s_dmaWindow = nullptr;
+static std::map<size_t, size_t> s_dmaBlocks; // Size of the allocated blocks, by offset.
+
+
+static void* allocateDMA(size_t size) {
+	if (s_dmaWindow == nullptr) {
+		s_dmaWindow = (uint8_t*) aligned_alloc(DMA_WINDOW_SIZE, DMA_WINDOW_SIZE);
+	}
+	size = (size + 3) & ~3;
+	size_t offset = 0;
+	for (std::map<size_t, size_t>::iterator i = s_dmaBlocks.begin(); i != s_dmaBlocks.end(); ++i) {
+		if (i->first - offset >= size) {
+			break;
+		}
+		offset = i->first + i->second;
+	}
+	if (DMA_WINDOW_SIZE - offset < size) {
+		return nullptr;
+	}
+	s_dmaBlocks[offset] = size;
+	return s_dmaWindow + offset;
+} // allocateDMA
+
+
+void* mock_dma_address(uint32_t address) {
+	return s_dmaWindow + (address & (DMA_WINDOW_SIZE - 1));
+} // mock_dma_address
+
+
+void* heap_caps_malloc(size_t size, uint32_t caps) {
+	// As on the ESP32, there is no PSRAM and nothing is returned for 0 bytes.
+	if (size == 0 || (caps & MALLOC_CAP_SPIRAM)) {
+		return nullptr;
+	}
+	if (caps & MALLOC_CAP_DMA) {
+		return allocateDMA(size);
+	}
+	return malloc(size);
+} // heap_caps_malloc
+
+
+void heap_caps_free(void* ptr) {
+	uint8_t* p = (uint8_t*) ptr;
+	if (s_dmaWindow != nullptr && p >= s_dmaWindow && p < s_dmaWindow + DMA_WINDOW_SIZE) {
+		s_dmaBlocks.erase(p - s_dmaWindow);
+		return;
+	}
+	free(ptr);
+} // heap_caps_free
+
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+	return (caps & MALLOC_CAP_SPIRAM) ? 0 : 320 * 1024;
+} // heap_caps_get_free_size
+
+
+int64_t esp_timer_get_time() {
+	static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+} // esp_timer_get_time
+
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level) {
+	return ESP_OK;
+} // gpio_set_level
+
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode) {
+	return ESP_OK;
+} // gpio_set_direction
+
+
+void gpio_pad_select_gpio(uint8_t gpio_num) {
+} // gpio_pad_select_gpio
+
+
+bool ESP32CPP::GPIO::inRange(gpio_num_t pin) {
+	return pin >= 0 && pin < GPIO_NUM_MAX;
+} // inRange
+
+
+void mock_reset() {
+	for (int channel = 0; channel < RMT_CHANNEL_MAX; channel++) {
+		mock_rmt[channel].items.clear();
+		mock_rmt[channel].frames = 0;
+	}
+	for (int host = 0; host < 3; host++) {
+		mock_spi[host].bytes.clear();
+		mock_spi[host].transactions = 0;
+	}
+	for (int port = 0; port < 2; port++) {
+		mock_i2s[port].slots.clear();
+		mock_i2s[port].frames  = 0;
+		mock_i2s[port].stopped = false;
+	}
+	mock_udp_sent.clear();
+	mock_udp_groups.clear();
+	mock_pbuf_size = 1600;
+} // mock_reset
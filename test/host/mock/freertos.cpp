@@ -0,0 +1,206 @@
+/*
+ * Host mock of FreeRTOS: tasks are detached host threads and ticks count the time elapsed since
+ * the start of the test at configTICK_RATE_HZ.
+ */
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+#include "mock.h"
+
+struct mock_task {
+	std::mutex mutex;
+	std::condition_variable notified;
+	uint32_t notifications;
+	uint32_t stackDepth;
+};
+
+struct mock_semaphore {
+	std::mutex mutex;
+	std::condition_variable given;
+	uint32_t count;
+	uint32_t maxCount;
+};
+
+static thread_local TaskHandle_t s_currentTask = nullptr;
+
+static void (*s_idleHook)() = nullptr;
+
+static const std::chrono::steady_clock::time_point s_start = std::chrono::steady_clock::now();
+
+
+static std::chrono::microseconds ticksToDuration(TickType_t ticks) {
+	return std::chrono::microseconds((uint64_t) ticks * 1000000 / configTICK_RATE_HZ);
+} // ticksToDuration
+
+
+void mock_set_idle_hook(void (*hook)()) {
+	s_idleHook = hook;
+} // mock_set_idle_hook
+
+
+/**
+ * @brief Wait on a condition for at most the given ticks, forever for portMAX_DELAY.
+ *
+ * Before blocking, the idle hook lets the peripherals finish what they were sending.
+ */
+template<typename Predicate>
+static bool waitFor(std::condition_variable& condition, std::unique_lock<std::mutex>& lock, TickType_t ticks,
+		Predicate predicate) {
+	if (ticks > 0 && s_idleHook != nullptr && !predicate()) {
+		lock.unlock();
+		s_idleHook();
+		lock.lock();
+	}
+	if (ticks == portMAX_DELAY) {
+		condition.wait(lock, predicate);
+		return true;
+	}
+	return condition.wait_for(lock, ticksToDuration(ticks), predicate);
+} // waitFor
+
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char* name, uint32_t stack_depth, void* parameters,
+		UBaseType_t priority, TaskHandle_t* created_task) {
+	TaskHandle_t task = new mock_task();
+	task->notifications = 0;
+	task->stackDepth    = stack_depth;
+	std::thread([code, parameters, task]() {
+		s_currentTask = task;
+		code(parameters);
+	}).detach();
+	if (created_task != nullptr) {
+		*created_task = task;
+	}
+	return pdPASS;
+} // xTaskCreate
+
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code, const char* name, uint32_t stack_depth,
+		void* parameters, UBaseType_t priority, TaskHandle_t* created_task, BaseType_t core_id) {
+	return xTaskCreate(code, name, stack_depth, parameters, priority, created_task);
+} // xTaskCreatePinnedToCore
+
+
+void vTaskDelete(TaskHandle_t task) {
+	// The tasks delete themselves as their last statement, so their thread ends on return.
+	if (task == nullptr || task == s_currentTask) {
+		delete s_currentTask;
+		s_currentTask = nullptr;
+	}
+} // vTaskDelete
+
+
+void vTaskDelay(TickType_t ticks) {
+	std::this_thread::sleep_for(ticksToDuration(ticks));
+} // vTaskDelay
+
+
+void vTaskDelayUntil(TickType_t* previous_wake_time, TickType_t time_increment) {
+	*previous_wake_time += time_increment;
+	std::this_thread::sleep_until(s_start + ticksToDuration(*previous_wake_time));
+} // vTaskDelayUntil
+
+
+TickType_t xTaskGetTickCount() {
+	std::chrono::microseconds elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - s_start);
+	return (TickType_t) ((uint64_t) elapsed.count() * configTICK_RATE_HZ / 1000000);
+} // xTaskGetTickCount
+
+
+/**
+ * @brief The host threads have their own stacks, the whole FreeRTOS stack is reported free.
+ */
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+	return task->stackDepth;
+} // uxTaskGetStackHighWaterMark
+
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+	if (s_currentTask == nullptr) {
+		// The main thread of the test.
+		s_currentTask = new mock_task();
+		s_currentTask->notifications = 0;
+		s_currentTask->stackDepth    = 0;
+	}
+	return s_currentTask;
+} // xTaskGetCurrentTaskHandle
+
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+	std::lock_guard<std::mutex> lock(task->mutex);
+	task->notifications++;
+	task->notified.notify_all();
+	return pdPASS;
+} // xTaskNotifyGive
+
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higher_priority_task_woken) {
+	xTaskNotifyGive(task);
+} // vTaskNotifyGiveFromISR
+
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_count_on_exit, TickType_t ticks_to_wait) {
+	TaskHandle_t task = xTaskGetCurrentTaskHandle();
+	std::unique_lock<std::mutex> lock(task->mutex);
+	waitFor(task->notified, lock, ticks_to_wait, [task]() { return task->notifications > 0; });
+	uint32_t count = task->notifications;
+	if (count > 0) {
+		task->notifications = clear_count_on_exit ? 0 : count - 1;
+	}
+	return count;
+} // ulTaskNotifyTake
+
+
+static SemaphoreHandle_t createSemaphore(uint32_t count, uint32_t maxCount) {
+	SemaphoreHandle_t semaphore = new mock_semaphore();
+	semaphore->count    = count;
+	semaphore->maxCount = maxCount;
+	return semaphore;
+} // createSemaphore
+
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+	return createSemaphore(0, 1);
+} // xSemaphoreCreateBinary
+
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+	return createSemaphore(1, 1);
+} // xSemaphoreCreateMutex
+
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+	std::lock_guard<std::mutex> lock(semaphore->mutex);
+	if (semaphore->count == semaphore->maxCount) {
+		return pdFAIL;
+	}
+	semaphore->count++;
+	semaphore->given.notify_one();
+	return pdPASS;
+} // xSemaphoreGive
+
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t* higher_priority_task_woken) {
+	return xSemaphoreGive(semaphore);
+} // xSemaphoreGiveFromISR
+
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait) {
+	std::unique_lock<std::mutex> lock(semaphore->mutex);
+	if (!waitFor(semaphore->given, lock, ticks_to_wait, [semaphore]() { return semaphore->count > 0; })) {
+		return pdFAIL;
+	}
+	semaphore->count--;
+	return pdPASS;
+} // xSemaphoreTake
+
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+	delete semaphore;
+} // vSemaphoreDelete
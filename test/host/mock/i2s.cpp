@@ -0,0 +1,142 @@
+/*
+ * Host mock of the I2S peripherals in 16 bits LCD mode, clocked out through their DMA
+ * descriptors, and of the GPIO matrix and interrupt allocation they use.
+ */
+#include <string.h>
+#include <driver/periph_ctrl.h>
+#include <esp_intr_alloc.h>
+#include <rom/gpio.h>
+#include <rom/lldesc.h>
+#include <soc/gpio_sig_map.h>
+#include <soc/i2s_reg.h>
+#include <soc/i2s_struct.h>
+#include <soc/soc.h>
+
+#include "mock.h"
+
+i2s_dev_t I2S0;
+i2s_dev_t I2S1;
+
+mock_i2s_port_t mock_i2s[2];
+
+// Slots still in the FIFO when the DMA has read the last descriptor, 64 words of 2 slots.
+static const size_t FIFO_SLOTS = 128;
+
+static intr_handler_t s_handlers[2];
+static void*          s_handlerArgs[2];
+
+
+static i2s_dev_t* getDevice(int port) {
+	return port == 0 ? &I2S0 : &I2S1;
+} // getDevice
+
+
+static void idle() {
+	mock_i2s_clock_out(0);
+	mock_i2s_clock_out(1);
+} // idle
+
+
+static struct IdleHook {
+	IdleHook() {
+		mock_set_idle_hook(idle);
+	}
+} s_idleHook;
+
+
+double mock_i2s_slot_ns(int port) {
+	i2s_dev_t* i2s = getDevice(port);
+	double divider = i2s->clkm_conf.clkm_div_num;
+	if (i2s->clkm_conf.clkm_div_a != 0) {
+		divider += (double) i2s->clkm_conf.clkm_div_b / i2s->clkm_conf.clkm_div_a;
+	}
+	return divider * i2s->sample_rate_conf.tx_bck_div_num * 1e9 / APB_CLK_FREQ;
+} // mock_i2s_slot_ns
+
+
+/**
+ * @brief Raise an interrupt of a peripheral, calling its handler if the interrupt is enabled.
+ */
+static void raiseInterrupt(int port, uint32_t mask) {
+	i2s_dev_t* i2s = getDevice(port);
+	i2s->int_raw.val |= mask;
+	i2s->int_st.val = i2s->int_raw.val & i2s->int_ena.val;
+	if (i2s->int_st.val != 0 && s_handlers[port] != nullptr) {
+		s_handlers[port](s_handlerArgs[port]);
+	}
+	// The bits written to int_clr clear the raw interrupts.
+	i2s->int_raw.val &= ~i2s->int_clr.val;
+	i2s->int_clr.val = 0;
+	i2s->int_st.val  = i2s->int_raw.val & i2s->int_ena.val;
+} // raiseInterrupt
+
+
+bool mock_i2s_clock_out(int port) {
+	i2s_dev_t*       i2s     = getDevice(port);
+	mock_i2s_port_t* capture = &mock_i2s[port];
+	if (!i2s->conf.tx_start || !i2s->out_link.start) {
+		return false;
+	}
+	i2s->out_link.start = 0;
+	i2s->int_raw.val &= ~i2s->int_clr.val;
+	i2s->int_clr.val = 0;
+
+	// Each 32 bits word read by the DMA is sent high half first.
+	capture->slots.clear();
+	lldesc_t* descriptor = (lldesc_t*) mock_dma_address(i2s->out_link.addr);
+	while (descriptor != nullptr && descriptor->owner) {
+		const volatile uint8_t* buffer = descriptor->buf;
+		for (uint32_t i = 0; i + 4 <= descriptor->length; i += 4) {
+			uint32_t word;
+			memcpy(&word, (const void*) (buffer + i), sizeof(word));
+			capture->slots.push_back(word >> 16);
+			capture->slots.push_back(word & 0xffff);
+		}
+		if (descriptor->eof) {
+			break;
+		}
+		descriptor = descriptor->qe.stqe_next;
+	}
+	capture->frames++;
+
+	raiseInterrupt(port, I2S_OUT_TOTAL_EOF_INT_ST);
+	if (!i2s->conf.tx_start) {
+		capture->slots.resize(capture->slots.size() > FIFO_SLOTS ? capture->slots.size() - FIFO_SLOTS : 0);
+	} else {
+		raiseInterrupt(port, I2S_TX_REMPTY_INT_ST);
+	}
+	capture->stopped = !i2s->conf.tx_start;
+	return true;
+} // mock_i2s_clock_out
+
+
+void periph_module_enable(periph_module_t periph) {
+} // periph_module_enable
+
+
+void gpio_matrix_out(uint32_t gpio, uint32_t signal_idx, bool out_inv, bool oen_inv) {
+	// In 16 bits LCD mode, the data bits are output on the DATA_OUT8 to DATA_OUT23 signals.
+	if (signal_idx >= I2S0O_DATA_OUT0_IDX + 8 && signal_idx < I2S0O_DATA_OUT0_IDX + 24) {
+		mock_i2s[0].pins[signal_idx - I2S0O_DATA_OUT0_IDX - 8] = (gpio_num_t) gpio;
+	} else if (signal_idx >= I2S1O_DATA_OUT0_IDX + 8 && signal_idx < I2S1O_DATA_OUT0_IDX + 24) {
+		mock_i2s[1].pins[signal_idx - I2S1O_DATA_OUT0_IDX - 8] = (gpio_num_t) gpio;
+	}
+} // gpio_matrix_out
+
+
+esp_err_t esp_intr_alloc(int source, int flags, intr_handler_t handler, void* arg, intr_handle_t* ret_handle) {
+	if (source != ETS_I2S0_INTR_SOURCE && source != ETS_I2S1_INTR_SOURCE) {
+		return ESP_ERR_NOT_FOUND;
+	}
+	int port = source == ETS_I2S0_INTR_SOURCE ? 0 : 1;
+	s_handlers[port]    = handler;
+	s_handlerArgs[port] = arg;
+	*ret_handle = &s_handlers[port];
+	return ESP_OK;
+} // esp_intr_alloc
+
+
+esp_err_t esp_intr_free(intr_handle_t handle) {
+	*(intr_handler_t*) handle = nullptr;
+	return ESP_OK;
+} // esp_intr_free
@@ -0,0 +1,33 @@
+#ifndef HOST_DRIVER_GPIO_H_
+#define HOST_DRIVER_GPIO_H_
+#include <stdint.h>
+#include "esp_err.h"
+
+#define IRAM_ATTR
+
+typedef enum {
+	GPIO_NUM_0, GPIO_NUM_1, GPIO_NUM_2, GPIO_NUM_3, GPIO_NUM_4, GPIO_NUM_5, GPIO_NUM_6, GPIO_NUM_7,
+	GPIO_NUM_8, GPIO_NUM_9, GPIO_NUM_10, GPIO_NUM_11, GPIO_NUM_12, GPIO_NUM_13, GPIO_NUM_14, GPIO_NUM_15,
+	GPIO_NUM_16, GPIO_NUM_17, GPIO_NUM_18, GPIO_NUM_19, GPIO_NUM_21 = 21, GPIO_NUM_22, GPIO_NUM_23,
+	GPIO_NUM_25 = 25, GPIO_NUM_26, GPIO_NUM_27,
+	GPIO_NUM_32 = 32, GPIO_NUM_33, GPIO_NUM_34, GPIO_NUM_35, GPIO_NUM_36, GPIO_NUM_37, GPIO_NUM_38, GPIO_NUM_39,
+	GPIO_NUM_MAX
+} gpio_num_t;
+
+typedef enum {
+	GPIO_INTR_DISABLE = 0,
+	GPIO_INTR_ANYEDGE = 3
+} gpio_int_type_t;
+
+typedef void (*gpio_isr_t)(void* arg);
+
+typedef enum {
+	GPIO_MODE_INPUT  = 1,
+	GPIO_MODE_OUTPUT = 2
+} gpio_mode_t;
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level);
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode);
+void      gpio_pad_select_gpio(uint8_t gpio_num);
+
+#endif
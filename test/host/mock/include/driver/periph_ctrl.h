@@ -0,0 +1,11 @@
+#ifndef HOST_DRIVER_PERIPH_CTRL_H_
+#define HOST_DRIVER_PERIPH_CTRL_H_
+
+typedef enum {
+	PERIPH_I2S0_MODULE,
+	PERIPH_I2S1_MODULE
+} periph_module_t;
+
+void periph_module_enable(periph_module_t periph);
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef HOST_DRIVER_SPI_MASTER_H_
+#define HOST_DRIVER_SPI_MASTER_H_
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+typedef enum {
+	SPI_HOST  = 0,
+	HSPI_HOST = 1,
+	VSPI_HOST = 2
+} spi_host_device_t;
+
+typedef struct {
+	int mosi_io_num;
+	int miso_io_num;
+	int sclk_io_num;
+	int quadwp_io_num;
+	int quadhd_io_num;
+	int max_transfer_sz;
+	uint32_t flags;
+} spi_bus_config_t;
+
+typedef struct spi_transaction_t spi_transaction_t;
+typedef void (*transaction_cb_t)(spi_transaction_t* trans);
+
+typedef struct {
+	uint8_t command_bits;
+	uint8_t address_bits;
+	uint8_t dummy_bits;
+	uint8_t mode;
+	int clock_speed_hz;
+	int spics_io_num;
+	uint32_t flags;
+	int queue_size;
+	transaction_cb_t pre_cb;
+	transaction_cb_t post_cb;
+} spi_device_interface_config_t;
+
+struct spi_transaction_t {
+	uint32_t flags;
+	uint16_t cmd;
+	uint64_t addr;
+	size_t length;      // In bits.
+	size_t rxlength;
+	void* user;
+	const void* tx_buffer;
+	void* rx_buffer;
+};
+
+typedef struct spi_device_t* spi_device_handle_t;
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t* bus_config, int dma_chan);
+esp_err_t spi_bus_free(spi_host_device_t host);
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t* dev_config,
+		spi_device_handle_t* handle);
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle);
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t* trans_desc, TickType_t ticks_to_wait);
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t** trans_desc,
+		TickType_t ticks_to_wait);
+
+#endif
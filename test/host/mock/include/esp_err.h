@@ -0,0 +1,30 @@
+/*
+ * Host mock of the ESP-IDF headers: only what the firmware modules built by the harness use.
+ */
+#ifndef HOST_ESP_ERR_H_
+#define HOST_ESP_ERR_H_
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK                0
+#define ESP_FAIL              -1
+#define ESP_ERR_NO_MEM        0x101
+#define ESP_ERR_INVALID_ARG   0x102
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_ERR_INVALID_SIZE  0x104
+#define ESP_ERR_NOT_FOUND     0x105
+#define ESP_ERR_TIMEOUT       0x107
+
+#define ESP_ERROR_CHECK(x) do {                                              \
+		esp_err_t __err = (x);                                                \
+		if (__err != ESP_OK) {                                                \
+			fprintf(stderr, "%s:%d: %s failed: 0x%x\n", __FILE__, __LINE__, #x, __err); \
+			abort();                                                          \
+		}                                                                     \
+	} while (0)
+
+#endif
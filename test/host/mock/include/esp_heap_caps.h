@@ -0,0 +1,16 @@
+#ifndef HOST_ESP_HEAP_CAPS_H_
+#define HOST_ESP_HEAP_CAPS_H_
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_32BIT    (1 << 1)
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_DMA      (1 << 3)
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+void*  heap_caps_malloc(size_t size, uint32_t caps);
+void   heap_caps_free(void* ptr);
+size_t heap_caps_get_free_size(uint32_t caps);
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef HOST_ESP_HTTP_CLIENT_H_
+#define HOST_ESP_HTTP_CLIENT_H_
+#include "esp_err.h"
+
+typedef struct esp_http_client_event esp_http_client_event_t;
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef HOST_ESP_INTR_ALLOC_H_
+#define HOST_ESP_INTR_ALLOC_H_
+#include "esp_err.h"
+
+typedef void* intr_handle_t;
+typedef void (*intr_handler_t)(void* arg);
+
+#define ETS_I2S0_INTR_SOURCE 32
+#define ETS_I2S1_INTR_SOURCE 33
+#define ESP_INTR_FLAG_IRAM   (1 << 10)
+
+esp_err_t esp_intr_alloc(int source, int flags, intr_handler_t handler, void* arg, intr_handle_t* ret_handle);
+esp_err_t esp_intr_free(intr_handle_t handle);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef HOST_ESP_LOG_H_
+#define HOST_ESP_LOG_H_
+#include <stdio.h>
+
+// Errors and warnings are printed, the other levels are only type checked.
+#define ESP_LOGE(tag, format, ...) fprintf(stderr, "E %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) fprintf(stderr, "W %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) do { if (0) printf("%s: " format, tag, ##__VA_ARGS__); } while (0)
+#define ESP_LOGD(tag, format, ...) do { if (0) printf("%s: " format, tag, ##__VA_ARGS__); } while (0)
+#define ESP_LOGV(tag, format, ...) do { if (0) printf("%s: " format, tag, ##__VA_ARGS__); } while (0)
+
+#define LOG_COLOR_I     ""
+#define LOG_RESET_COLOR ""
+
+#endif
@@ -0,0 +1,4 @@
+#ifndef HOST_ESP_SYSTEM_H_
+#define HOST_ESP_SYSTEM_H_
+#include "esp_err.h"
+#endif
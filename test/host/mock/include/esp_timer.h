@@ -0,0 +1,8 @@
+#ifndef HOST_ESP_TIMER_H_
+#define HOST_ESP_TIMER_H_
+#include <stdint.h>
+
+// Microseconds of the host monotonic clock.
+int64_t esp_timer_get_time();
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef HOST_FREERTOS_H_
+#define HOST_FREERTOS_H_
+#include <stdint.h>
+#include "sdkconfig.h"
+
+typedef uint32_t TickType_t;
+typedef int      BaseType_t;
+typedef unsigned UBaseType_t;
+
+#define configTICK_RATE_HZ CONFIG_FREERTOS_HZ
+#define portMAX_DELAY      ((TickType_t) 0xffffffffUL)
+#define portTICK_PERIOD_MS ((TickType_t) 1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)  ((TickType_t) (((TickType_t) (ms) * (TickType_t) configTICK_RATE_HZ) / (TickType_t) 1000))
+
+#define pdFALSE 0
+#define pdTRUE  1
+#define pdFAIL  0
+#define pdPASS  1
+
+#define portYIELD_FROM_ISR() do { } while (0)
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef HOST_FREERTOS_SEMPHR_H_
+#define HOST_FREERTOS_SEMPHR_H_
+#include "freertos/FreeRTOS.h"
+
+typedef struct mock_semaphore* SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateBinary();
+SemaphoreHandle_t xSemaphoreCreateMutex();
+BaseType_t        xSemaphoreGive(SemaphoreHandle_t semaphore);
+BaseType_t        xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t* higher_priority_task_woken);
+BaseType_t        xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait);
+void              vSemaphoreDelete(SemaphoreHandle_t semaphore);
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef HOST_FREERTOS_TASK_H_
+#define HOST_FREERTOS_TASK_H_
+#include "freertos/FreeRTOS.h"
+
+// Tasks are host threads, ticks count the milliseconds of the host monotonic clock.
+typedef struct mock_task* TaskHandle_t;
+typedef void (*TaskFunction_t)(void* parameters);
+
+#define PRO_CPU_NUM 0
+#define APP_CPU_NUM 1
+
+BaseType_t   xTaskCreate(TaskFunction_t code, const char* name, uint32_t stack_depth, void* parameters,
+		UBaseType_t priority, TaskHandle_t* created_task);
+BaseType_t   xTaskCreatePinnedToCore(TaskFunction_t code, const char* name, uint32_t stack_depth,
+		void* parameters, UBaseType_t priority, TaskHandle_t* created_task, BaseType_t core_id);
+void         vTaskDelete(TaskHandle_t task);
+void         vTaskDelay(TickType_t ticks);
+void         vTaskDelayUntil(TickType_t* previous_wake_time, TickType_t time_increment);
+TickType_t   xTaskGetTickCount();
+UBaseType_t  uxTaskGetStackHighWaterMark(TaskHandle_t task);
+TaskHandle_t xTaskGetCurrentTaskHandle();
+BaseType_t   xTaskNotifyGive(TaskHandle_t task);
+void         vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higher_priority_task_woken);
+uint32_t     ulTaskNotifyTake(BaseType_t clear_count_on_exit, TickType_t ticks_to_wait);
+
+#endif
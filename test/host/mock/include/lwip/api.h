@@ -0,0 +1,52 @@
+#ifndef HOST_LWIP_API_H_
+#define HOST_LWIP_API_H_
+#include <stdint.h>
+#include "lwip/err.h"
+
+typedef uint8_t  u8_t;
+typedef uint16_t u16_t;
+typedef uint32_t u32_t;
+
+// IPv4 addresses, in network byte order as lwIP keeps them.
+typedef struct {
+	u32_t addr;
+} ip_addr_t;
+
+typedef ip_addr_t ip4_addr_t;
+
+#define IP_ADDR4(ipaddr, a, b, c, d) \
+	((ipaddr)->addr = (u32_t) (a) | (u32_t) (b) << 8 | (u32_t) (c) << 16 | (u32_t) (d) << 24)
+
+extern const ip_addr_t ip_addr_any;
+#define IP_ADDR_ANY (&ip_addr_any)
+
+enum netconn_type {
+	NETCONN_UDP = 0x20
+};
+
+enum netconn_igmp {
+	NETCONN_JOIN,
+	NETCONN_LEAVE
+};
+
+struct netconn;
+struct netbuf;
+
+struct netconn*  netconn_new(enum netconn_type type);
+err_t            netconn_bind(struct netconn* conn, const ip_addr_t* addr, u16_t port);
+void             netconn_set_recvtimeout(struct netconn* conn, int timeout);
+err_t            netconn_recv(struct netconn* conn, struct netbuf** new_buf);
+err_t            netconn_sendto(struct netconn* conn, struct netbuf* buf, const ip_addr_t* addr, u16_t port);
+err_t            netconn_join_leave_group(struct netconn* conn, const ip_addr_t* multiaddr,
+	const ip_addr_t* netif_addr, enum netconn_igmp join_or_leave);
+err_t            netconn_delete(struct netconn* conn);
+
+struct netbuf*   netbuf_new();
+void*            netbuf_alloc(struct netbuf* buf, u16_t size);
+void             netbuf_delete(struct netbuf* buf);
+err_t            netbuf_data(struct netbuf* buf, void** dataptr, u16_t* len);
+u16_t            netbuf_len(struct netbuf* buf);
+u16_t            netbuf_copy(struct netbuf* buf, void* dataptr, u16_t len);
+const ip_addr_t* netbuf_fromaddr(struct netbuf* buf);
+
+#endif
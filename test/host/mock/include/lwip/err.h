@@ -0,0 +1,15 @@
+#ifndef HOST_LWIP_ERR_H_
+#define HOST_LWIP_ERR_H_
+#include <stdint.h>
+
+typedef int8_t err_t;
+
+#define ERR_OK      0
+#define ERR_MEM     -1
+#define ERR_TIMEOUT -3
+#define ERR_VAL     -6
+#define ERR_USE     -8
+#define ERR_CONN    -11
+#define ERR_ARG     -16
+
+#endif
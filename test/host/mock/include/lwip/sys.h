@@ -0,0 +1,4 @@
+#ifndef HOST_LWIP_SYS_H_
+#define HOST_LWIP_SYS_H_
+#include "lwip/err.h"
+#endif
@@ -0,0 +1,25 @@
+#ifndef HOST_NVS_FLASH_H_
+#define HOST_NVS_FLASH_H_
+#include <stdint.h>
+#include "esp_err.h"
+
+#define ESP_ERR_NVS_NOT_FOUND 0x1102
+
+typedef uint32_t nvs_handle;
+
+typedef enum {
+	NVS_READONLY,
+	NVS_READWRITE
+} nvs_open_mode;
+
+esp_err_t nvs_open(const char* name, nvs_open_mode open_mode, nvs_handle* out_handle);
+esp_err_t nvs_get_u8(nvs_handle handle, const char* key, uint8_t* out_value);
+esp_err_t nvs_get_u16(nvs_handle handle, const char* key, uint16_t* out_value);
+esp_err_t nvs_get_i32(nvs_handle handle, const char* key, int32_t* out_value);
+esp_err_t nvs_set_u8(nvs_handle handle, const char* key, uint8_t value);
+esp_err_t nvs_set_u16(nvs_handle handle, const char* key, uint16_t value);
+esp_err_t nvs_set_i32(nvs_handle handle, const char* key, int32_t value);
+esp_err_t nvs_commit(nvs_handle handle);
+void      nvs_close(nvs_handle handle);
+
+#endif
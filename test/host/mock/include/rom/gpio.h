@@ -0,0 +1,7 @@
+#ifndef HOST_ROM_GPIO_H_
+#define HOST_ROM_GPIO_H_
+#include <stdint.h>
+
+void gpio_matrix_out(uint32_t gpio, uint32_t signal_idx, bool out_inv, bool oen_inv);
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef HOST_ROM_LLDESC_H_
+#define HOST_ROM_LLDESC_H_
+#include <stdint.h>
+
+typedef struct lldesc_s {
+	volatile uint32_t size   :12,
+	                  length :12,
+	                  offset : 5,
+	                  sosf   : 1,
+	                  eof    : 1,
+	                  owner  : 1;
+	volatile uint8_t* buf;
+	union {
+		volatile uint32_t empty;
+		struct {
+			struct lldesc_s* stqe_next;
+		} qe;
+	};
+} lldesc_t;
+
+#endif
@@ -0,0 +1,28 @@
+/*
+ * Host build configuration: the Kconfig defaults of main/Kconfig.projbuild, GPIO 16 for the
+ * strip and the DMX receivers enabled so that their modules build.
+ */
+#ifndef HOST_SDKCONFIG_H_
+#define HOST_SDKCONFIG_H_
+
+#define CONFIG_FREERTOS_HZ 100
+#define CONFIG_CXX_EXCEPTIONS 1
+
+#define CONFIG_BLINK_GPIO 2
+#define CONFIG_LED_PIN 16
+#define CONFIG_NUM_LED 0
+#define CONFIG_STRIP_OUTPUT_RMT 1
+#define CONFIG_STRIP_RENDER_FPS 60
+#define CONFIG_STRIP_FADE_TIME 300
+#define CONFIG_STRIP_GAMMA 10
+#define CONFIG_STRIP_POWER_LIMIT 0
+#define CONFIG_MQTT_TELEMETRY_PERIOD 10
+
+#define CONFIG_E131_RECEIVER 1
+#define CONFIG_E131_UNIVERSE 1
+#define CONFIG_E131_START_CHANNEL 1
+#define CONFIG_ARTNET_NODE 1
+#define CONFIG_ARTNET_UNIVERSE 0
+#define CONFIG_ARTNET_START_CHANNEL 1
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef HOST_SOC_GPIO_SIG_MAP_H_
+#define HOST_SOC_GPIO_SIG_MAP_H_
+
+#define I2S0O_DATA_OUT0_IDX 140
+#define I2S1O_DATA_OUT0_IDX 166
+
+#endif
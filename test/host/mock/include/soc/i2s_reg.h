@@ -0,0 +1,7 @@
+#ifndef HOST_SOC_I2S_REG_H_
+#define HOST_SOC_I2S_REG_H_
+
+#define I2S_TX_REMPTY_INT_ST     (1u << 5)
+#define I2S_OUT_TOTAL_EOF_INT_ST (1u << 16)
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef HOST_SOC_I2S_STRUCT_H_
+#define HOST_SOC_I2S_STRUCT_H_
+#include <stdint.h>
+
+// The registers used by the drivers, only the interrupt registers have the ESP32 bit layout.
+#define I2S_INT_BITS                \
+	uint32_t rx_take_data  : 1;     \
+	uint32_t tx_put_data   : 1;     \
+	uint32_t rx_wfull      : 1;     \
+	uint32_t rx_rempty     : 1;     \
+	uint32_t tx_wfull      : 1;     \
+	uint32_t tx_rempty     : 1;     \
+	uint32_t rx_hung       : 1;     \
+	uint32_t tx_hung       : 1;     \
+	uint32_t in_done       : 1;     \
+	uint32_t in_suc_eof    : 1;     \
+	uint32_t in_err_eof    : 1;     \
+	uint32_t out_done      : 1;     \
+	uint32_t out_eof       : 1;     \
+	uint32_t in_dscr_err   : 1;     \
+	uint32_t out_dscr_err  : 1;     \
+	uint32_t in_dscr_empty : 1;     \
+	uint32_t out_total_eof : 1;
+
+typedef volatile struct i2s_dev_s {
+	union {
+		struct {
+			uint32_t tx_reset       : 1;
+			uint32_t rx_reset       : 1;
+			uint32_t tx_fifo_reset  : 1;
+			uint32_t rx_fifo_reset  : 1;
+			uint32_t tx_start       : 1;
+			uint32_t rx_start       : 1;
+			uint32_t tx_slave_mod   : 1;
+			uint32_t tx_right_first : 1;
+			uint32_t tx_msb_shift   : 1;
+			uint32_t tx_short_sync  : 1;
+			uint32_t tx_mono        : 1;
+			uint32_t tx_msb_right   : 1;
+		};
+		uint32_t val;
+	} conf;
+	union {
+		struct {
+			uint32_t in_rst        : 1;
+			uint32_t out_rst       : 1;
+			uint32_t ahbm_fifo_rst : 1;
+			uint32_t ahbm_rst      : 1;
+		};
+		uint32_t val;
+	} lc_conf;
+	union {
+		struct {
+			uint32_t lcd_en         : 1;
+			uint32_t lcd_tx_wrx2_en : 1;
+			uint32_t lcd_tx_sdx2_en : 1;
+		};
+		uint32_t val;
+	} conf2;
+	union {
+		struct {
+			uint32_t tx_bck_div_num : 6;
+			uint32_t tx_bits_mod    : 6;
+		};
+		uint32_t val;
+	} sample_rate_conf;
+	union {
+		struct {
+			uint32_t clkm_div_num : 8;
+			uint32_t clkm_div_b   : 6;
+			uint32_t clkm_div_a   : 6;
+			uint32_t clka_en      : 1;
+		};
+		uint32_t val;
+	} clkm_conf;
+	union {
+		struct {
+			uint32_t tx_data_num          : 6;
+			uint32_t dscr_en              : 1;
+			uint32_t tx_fifo_mod          : 3;
+			uint32_t tx_fifo_mod_force_en : 1;
+		};
+		uint32_t val;
+	} fifo_conf;
+	union {
+		struct {
+			uint32_t tx_pcm_bypass : 1;
+			uint32_t tx_stop_en    : 1;
+		};
+		uint32_t val;
+	} conf1;
+	union {
+		struct {
+			uint32_t tx_chan_mod : 3;
+		};
+		uint32_t val;
+	} conf_chan;
+	union {
+		uint32_t val;
+	} timing;
+	union {
+		struct {
+			uint32_t addr  : 20;
+			uint32_t stop  : 1;
+			uint32_t start : 1;
+		};
+		uint32_t val;
+	} out_link;
+	union {
+		struct {
+			I2S_INT_BITS
+		};
+		uint32_t val;
+	} int_raw;
+	union {
+		struct {
+			I2S_INT_BITS
+		};
+		uint32_t val;
+	} int_st;
+	union {
+		struct {
+			I2S_INT_BITS
+		};
+		uint32_t val;
+	} int_ena;
+	union {
+		struct {
+			I2S_INT_BITS
+		};
+		uint32_t val;
+	} int_clr;
+} i2s_dev_t;
+
+#undef I2S_INT_BITS
+
+extern i2s_dev_t I2S0;
+extern i2s_dev_t I2S1;
+
+#endif
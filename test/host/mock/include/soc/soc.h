@@ -0,0 +1,6 @@
+#ifndef HOST_SOC_SOC_H_
+#define HOST_SOC_SOC_H_
+
+#define APB_CLK_FREQ (80 * 1000000)
+
+#endif
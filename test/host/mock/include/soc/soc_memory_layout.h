@@ -0,0 +1,9 @@
+#ifndef HOST_SOC_MEMORY_LAYOUT_H_
+#define HOST_SOC_MEMORY_LAYOUT_H_
+
+// The host has no PSRAM: MALLOC_CAP_SPIRAM allocations fail and the strips stay in internal RAM.
+static inline bool esp_ptr_external_ram(const void* p) {
+	return false;
+}
+
+#endif
@@ -0,0 +1,244 @@
+/*
+ * Host mock of the lwIP netconn API over host UDP sockets, and of the network interface
+ * queries of the ESP-IDF.
+ *
+ * The modules receive real datagrams, sent by the tests to 127.0.0.1.  Multicast is not routed
+ * on the loopback interface, so the groups joined and not left yet are only recorded.
+ */
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <esp_wifi.h>
+#include <tcpip_adapter.h>
+#include <lwip/api.h>
+
+#include "mock.h"
+
+struct netconn {
+	int fd;
+	u16_t port;
+};
+
+struct netbuf {
+	std::vector<uint8_t> bytes;
+	ip_addr_t from;
+	bool received;
+};
+
+const ip_addr_t ip_addr_any = { 0 };
+
+std::vector<mock_datagram_t> mock_udp_sent;
+std::vector<uint32_t>        mock_udp_groups;
+size_t                       mock_pbuf_size = 1600;
+
+// Ports bound by the netconns, and datagrams the modules are done with.
+static std::mutex              s_mutex;
+static std::condition_variable s_changed;
+static std::vector<u16_t>      s_bound;
+static uint32_t                s_handled = 0;
+
+
+template<typename Predicate>
+static bool waitChange(uint32_t timeoutMs, Predicate predicate) {
+	std::unique_lock<std::mutex> lock(s_mutex);
+	return s_changed.wait_for(lock, std::chrono::milliseconds(timeoutMs), predicate);
+} // waitChange
+
+
+bool mock_netconn_wait_bound(uint16_t port, uint32_t timeoutMs) {
+	return waitChange(timeoutMs, [port]() {
+		for (size_t i = 0; i < s_bound.size(); i++) {
+			if (s_bound[i] == port) {
+				return true;
+			}
+		}
+		return false;
+	});
+} // mock_netconn_wait_bound
+
+
+uint32_t mock_netconn_handled() {
+	std::lock_guard<std::mutex> lock(s_mutex);
+	return s_handled;
+} // mock_netconn_handled
+
+
+bool mock_netconn_wait_handled(uint32_t count, uint32_t timeoutMs) {
+	return waitChange(timeoutMs, [count]() { return s_handled >= count; });
+} // mock_netconn_wait_handled
+
+
+struct netconn* netconn_new(enum netconn_type type) {
+	int fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0) {
+		return nullptr;
+	}
+	int reuse = 1;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+	struct netconn* conn = new netconn();
+	conn->fd   = fd;
+	conn->port = 0;
+	return conn;
+} // netconn_new
+
+
+err_t netconn_bind(struct netconn* conn, const ip_addr_t* addr, u16_t port) {
+	struct sockaddr_in local = { };
+	local.sin_family      = AF_INET;
+	local.sin_addr.s_addr = addr->addr;
+	local.sin_port        = htons(port);
+	if (bind(conn->fd, (struct sockaddr*) &local, sizeof(local)) != 0) {
+		return ERR_USE;
+	}
+	std::lock_guard<std::mutex> lock(s_mutex);
+	conn->port = port;
+	s_bound.push_back(port);
+	s_changed.notify_all();
+	return ERR_OK;
+} // netconn_bind
+
+
+void netconn_set_recvtimeout(struct netconn* conn, int timeout) {
+	struct timeval tv;
+	tv.tv_sec  = timeout / 1000;
+	tv.tv_usec = (timeout % 1000) * 1000;
+	setsockopt(conn->fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+} // netconn_set_recvtimeout
+
+
+err_t netconn_recv(struct netconn* conn, struct netbuf** new_buf) {
+	uint8_t datagram[65536];
+	struct sockaddr_in from;
+	socklen_t fromLength = sizeof(from);
+	ssize_t length = recvfrom(conn->fd, datagram, sizeof(datagram), 0, (struct sockaddr*) &from, &fromLength);
+	if (length < 0) {
+		return ERR_TIMEOUT;
+	}
+	struct netbuf* buf = new netbuf();
+	buf->bytes.assign(datagram, datagram + length);
+	buf->from.addr = from.sin_addr.s_addr;
+	buf->received  = true;
+	*new_buf = buf;
+	return ERR_OK;
+} // netconn_recv
+
+
+err_t netconn_sendto(struct netconn* conn, struct netbuf* buf, const ip_addr_t* addr, u16_t port) {
+	mock_datagram_t datagram;
+	datagram.address = addr->addr;
+	datagram.port    = port;
+	datagram.bytes   = buf->bytes;
+	mock_udp_sent.push_back(datagram);
+
+	struct sockaddr_in to = { };
+	to.sin_family      = AF_INET;
+	to.sin_addr.s_addr = addr->addr;
+	to.sin_port        = htons(port);
+	if (sendto(conn->fd, buf->bytes.data(), buf->bytes.size(), 0, (struct sockaddr*) &to, sizeof(to)) < 0) {
+		return ERR_CONN;
+	}
+	return ERR_OK;
+} // netconn_sendto
+
+
+err_t netconn_join_leave_group(struct netconn* conn, const ip_addr_t* multiaddr, const ip_addr_t* netif_addr,
+		enum netconn_igmp join_or_leave) {
+	if (join_or_leave == NETCONN_JOIN) {
+		mock_udp_groups.push_back(multiaddr->addr);
+		return ERR_OK;
+	}
+	// As lwIP, each join is left once, and a group not joined can not be left.
+	for (size_t i = 0; i < mock_udp_groups.size(); i++) {
+		if (mock_udp_groups[i] == multiaddr->addr) {
+			mock_udp_groups.erase(mock_udp_groups.begin() + i);
+			return ERR_OK;
+		}
+	}
+	return ERR_VAL;
+} // netconn_join_leave_group
+
+
+err_t netconn_delete(struct netconn* conn) {
+	std::lock_guard<std::mutex> lock(s_mutex);
+	for (size_t i = 0; i < s_bound.size(); i++) {
+		if (s_bound[i] == conn->port) {
+			s_bound.erase(s_bound.begin() + i);
+			break;
+		}
+	}
+	close(conn->fd);
+	delete conn;
+	return ERR_OK;
+} // netconn_delete
+
+
+struct netbuf* netbuf_new() {
+	struct netbuf* buf = new netbuf();
+	buf->from.addr = 0;
+	buf->received  = false;
+	return buf;
+} // netbuf_new
+
+
+void* netbuf_alloc(struct netbuf* buf, u16_t size) {
+	buf->bytes.resize(size);
+	return buf->bytes.data();
+} // netbuf_alloc
+
+
+void netbuf_delete(struct netbuf* buf) {
+	if (buf->received) {
+		std::lock_guard<std::mutex> lock(s_mutex);
+		s_handled++;
+		s_changed.notify_all();
+	}
+	delete buf;
+} // netbuf_delete
+
+
+/**
+ * @brief The first pbuf of a datagram, which holds at most mock_pbuf_size bytes.
+ */
+err_t netbuf_data(struct netbuf* buf, void** dataptr, u16_t* len) {
+	*dataptr = buf->bytes.data();
+	*len     = buf->bytes.size() < mock_pbuf_size ? buf->bytes.size() : mock_pbuf_size;
+	return ERR_OK;
+} // netbuf_data
+
+
+u16_t netbuf_len(struct netbuf* buf) {
+	return buf->bytes.size();
+} // netbuf_len
+
+
+u16_t netbuf_copy(struct netbuf* buf, void* dataptr, u16_t len) {
+	u16_t length = buf->bytes.size() < len ? buf->bytes.size() : len;
+	memcpy(dataptr, buf->bytes.data(), length);
+	return length;
+} // netbuf_copy
+
+
+const ip_addr_t* netbuf_fromaddr(struct netbuf* buf) {
+	return &buf->from;
+} // netbuf_fromaddr
+
+
+esp_err_t tcpip_adapter_get_ip_info(tcpip_adapter_if_t tcpip_if, tcpip_adapter_ip_info_t* ip_info) {
+	IP_ADDR4(&ip_info->ip, 127, 0, 0, 1);
+	IP_ADDR4(&ip_info->netmask, 255, 0, 0, 0);
+	IP_ADDR4(&ip_info->gw, 127, 0, 0, 1);
+	return ESP_OK;
+} // tcpip_adapter_get_ip_info
+
+
+esp_err_t esp_wifi_get_mac(wifi_interface_t ifx, uint8_t mac[6]) {
+	static const uint8_t MAC[6] = { 0x24, 0x0a, 0xc4, 0x01, 0x02, 0x03 };
+	memcpy(mac, MAC, sizeof(MAC));
+	return ESP_OK;
+} // esp_wifi_get_mac
@@ -0,0 +1,144 @@
+/*
+ * Host mock of the ESP32 peripherals used by the LED drivers.
+ *
+ * The mocks record what the drivers send, in the form the hardware would output it: the items
+ * of each RMT channel, the bytes of each SPI transaction and the slots clocked out by I2S.
+ * RMT and SPI frames complete as soon as they are written, and the completion callbacks are
+ * called before the write returns.  I2S frames are clocked out when a task would block, or
+ * by mock_i2s_clock_out(), running the interrupt handler as the hardware would.
+ *
+ * The netconns are host UDP sockets: the tests send datagrams to 127.0.0.1 and the mock records
+ * what the modules send back.
+ */
+#ifndef HOST_MOCK_H_
+#define HOST_MOCK_H_
+#include <stdint.h>
+#include <vector>
+#include <driver/rmt.h>
+#include <driver/spi_master.h>
+#include <driver/gpio.h>
+
+/**
+ * @brief What has been sent on an RMT channel.
+ */
+typedef struct {
+	rmt_config_t config;
+	bool installed;
+	sample_to_rmt_t translator;
+	std::vector<rmt_item32_t> items; // Items of the last frame, without the terminator.
+	uint32_t frames;
+	int64_t startUs;                 // esp_timer_get_time() when the last frame started.
+} mock_rmt_channel_t;
+
+/**
+ * @brief What has been sent on an SPI host.
+ */
+typedef struct {
+	spi_bus_config_t bus;
+	spi_device_interface_config_t device;
+	bool initialized;
+	std::vector<uint8_t> bytes;      // MOSI bytes of the last transaction.
+	uint32_t transactions;
+} mock_spi_host_t;
+
+/**
+ * @brief What has been clocked out by an I2S peripheral in 16 bits LCD mode.
+ */
+typedef struct {
+	std::vector<uint16_t> slots;     // Slots of the last frame, in the order they were sent.
+	uint32_t frames;
+	bool stopped;                    // Whether the output was stopped once the frame was sent.
+	gpio_num_t pins[16];             // Pin of each data bit, from gpio_matrix_out().
+} mock_i2s_port_t;
+
+/**
+ * @brief A UDP datagram sent by a netconn.
+ */
+typedef struct {
+	uint32_t address;                // Destination, in network byte order.
+	uint16_t port;
+	std::vector<uint8_t> bytes;
+} mock_datagram_t;
+
+extern mock_rmt_channel_t mock_rmt[RMT_CHANNEL_MAX];
+extern mock_spi_host_t    mock_spi[3];
+extern mock_i2s_port_t    mock_i2s[2];
+
+extern std::vector<mock_datagram_t> mock_udp_sent;    // Datagrams sent by the netconns.
+extern std::vector<uint32_t>        mock_udp_groups;  // Multicast groups joined and not left, in network byte order.
+extern size_t                       mock_pbuf_size;   // Bytes in the first pbuf of the datagrams received.
+
+/**
+ * @brief Duration of an RMT tick of a channel in ns, from its clock divider.
+ */
+double mock_rmt_tick_ns(rmt_channel_t channel);
+
+/**
+ * @brief Wait for the frames sent on an RMT channel by another task to reach a count.
+ *
+ * @return False on timeout.
+ */
+bool mock_rmt_wait_frames(rmt_channel_t channel, uint32_t count, uint32_t timeoutMs);
+
+/**
+ * @brief Set the function called as each RMT frame starts, before its items are recorded.
+ */
+void mock_set_rmt_start_hook(void (*hook)(rmt_channel_t channel));
+
+/**
+ * @brief Duration of an SPI bit in ns, for the clock the ESP32 derives from the requested one.
+ */
+double mock_spi_bit_ns(spi_host_device_t host);
+
+/**
+ * @brief Duration of an I2S slot in ns, from the clock registers of the peripheral.
+ */
+double mock_i2s_slot_ns(int port);
+
+/**
+ * @brief Clock out the frame started on an I2S peripheral, through its DMA descriptors.
+ *
+ * The out_total_eof interrupt is raised once the DMA has read the last descriptor, with the
+ * last 128 slots still in the FIFO, then tx_rempty once the FIFO has drained.  If the output is
+ * stopped before, the slots left in the FIFO are lost.
+ *
+ * @return True if a frame had been started.
+ */
+bool mock_i2s_clock_out(int port);
+
+/**
+ * @brief The address of DMA capable memory from the 20 low bits of its address, as used by
+ * the DMA registers.
+ */
+void* mock_dma_address(uint32_t address);
+
+/**
+ * @brief Set the function called when a task would block, to let the peripherals progress.
+ */
+void mock_set_idle_hook(void (*hook)());
+
+/**
+ * @brief Wait for a netconn to be bound to a port.
+ *
+ * @return False on timeout.
+ */
+bool mock_netconn_wait_bound(uint16_t port, uint32_t timeoutMs);
+
+/**
+ * @brief The number of datagrams received by the netconns and deleted once handled.
+ */
+uint32_t mock_netconn_handled();
+
+/**
+ * @brief Wait for mock_netconn_handled() to reach a count.
+ *
+ * @return False on timeout.
+ */
+bool mock_netconn_wait_handled(uint32_t count, uint32_t timeoutMs);
+
+/**
+ * @brief Forget everything sent, between tests.
+ */
+void mock_reset();
+
+#endif
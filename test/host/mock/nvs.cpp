@@ -0,0 +1,79 @@
+/*
+ * Host mock of the NVS: the values of each namespace are kept in memory until the end of the
+ * test.
+ */
+#include <map>
+#include <string>
+#include <vector>
+#include <nvs_flash.h>
+
+static std::vector<std::string>        s_namespaces; // Namespace of each handle, from 1.
+static std::map<std::string, int64_t>  s_values;     // Values by namespace and key.
+
+
+static std::string getKey(nvs_handle handle, const char* key) {
+	return s_namespaces[handle - 1] + "/" + key;
+} // getKey
+
+
+template<typename T>
+static esp_err_t getValue(nvs_handle handle, const char* key, T* out_value) {
+	std::map<std::string, int64_t>::iterator i = s_values.find(getKey(handle, key));
+	if (i == s_values.end()) {
+		return ESP_ERR_NVS_NOT_FOUND;
+	}
+	*out_value = (T) i->second;
+	return ESP_OK;
+} // getValue
+
+
+static esp_err_t setValue(nvs_handle handle, const char* key, int64_t value) {
+	s_values[getKey(handle, key)] = value;
+	return ESP_OK;
+} // setValue
+
+
+esp_err_t nvs_open(const char* name, nvs_open_mode open_mode, nvs_handle* out_handle) {
+	s_namespaces.push_back(name);
+	*out_handle = s_namespaces.size();
+	return ESP_OK;
+} // nvs_open
+
+
+esp_err_t nvs_get_u8(nvs_handle handle, const char* key, uint8_t* out_value) {
+	return getValue(handle, key, out_value);
+} // nvs_get_u8
+
+
+esp_err_t nvs_get_u16(nvs_handle handle, const char* key, uint16_t* out_value) {
+	return getValue(handle, key, out_value);
+} // nvs_get_u16
+
+
+esp_err_t nvs_get_i32(nvs_handle handle, const char* key, int32_t* out_value) {
+	return getValue(handle, key, out_value);
+} // nvs_get_i32
+
+
+esp_err_t nvs_set_u8(nvs_handle handle, const char* key, uint8_t value) {
+	return setValue(handle, key, value);
+} // nvs_set_u8
+
+
+esp_err_t nvs_set_u16(nvs_handle handle, const char* key, uint16_t value) {
+	return setValue(handle, key, value);
+} // nvs_set_u16
+
+
+esp_err_t nvs_set_i32(nvs_handle handle, const char* key, int32_t value) {
+	return setValue(handle, key, value);
+} // nvs_set_i32
+
+
+esp_err_t nvs_commit(nvs_handle handle) {
+	return ESP_OK;
+} // nvs_commit
+
+
+void nvs_close(nvs_handle handle) {
+} // nvs_close
@@ -0,0 +1,155 @@
+/*
+ * Host mock of the RMT driver.
+ *
+ * rmt_write_sample() calls the translator as the ESP-IDF driver does: once for the whole channel
+ * memory, then for each half of it as it drains.
+ */
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <esp_timer.h>
+#include <soc/soc.h>
+
+#include "mock.h"
+
+mock_rmt_channel_t mock_rmt[RMT_CHANNEL_MAX];
+
+static const size_t RMT_MEM_ITEM_NUM = 64;
+
+static rmt_tx_end_callback_t s_txEndCallback = { nullptr, nullptr };
+
+static void (*s_startHook)(rmt_channel_t channel) = nullptr;
+
+// Frames written by other tasks are waited for with mock_rmt_wait_frames().
+static std::mutex              s_mutex;
+static std::condition_variable s_frameEnded;
+
+
+double mock_rmt_tick_ns(rmt_channel_t channel) {
+	return mock_rmt[channel].config.clk_div * 1e9 / APB_CLK_FREQ;
+} // mock_rmt_tick_ns
+
+
+bool mock_rmt_wait_frames(rmt_channel_t channel, uint32_t count, uint32_t timeoutMs) {
+	std::unique_lock<std::mutex> lock(s_mutex);
+	return s_frameEnded.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+		[channel, count]() { return mock_rmt[channel].frames >= count; });
+} // mock_rmt_wait_frames
+
+
+void mock_set_rmt_start_hook(void (*hook)(rmt_channel_t channel)) {
+	s_startHook = hook;
+} // mock_set_rmt_start_hook
+
+
+static void startFrame(rmt_channel_t channel) {
+	if (s_startHook != nullptr) {
+		s_startHook(channel);
+	}
+	mock_rmt[channel].startUs = esp_timer_get_time();
+} // startFrame
+
+
+static void endFrame(rmt_channel_t channel) {
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+		mock_rmt[channel].frames++;
+		s_frameEnded.notify_all();
+	}
+	if (s_txEndCallback.function != nullptr) {
+		s_txEndCallback.function(channel, s_txEndCallback.arg);
+	}
+} // endFrame
+
+
+esp_err_t rmt_config(const rmt_config_t* rmt_param) {
+	if (rmt_param->channel >= RMT_CHANNEL_MAX || rmt_param->clk_div == 0 ||
+			rmt_param->channel + rmt_param->mem_block_num > RMT_CHANNEL_MAX) {
+		return ESP_ERR_INVALID_ARG;
+	}
+	mock_rmt[rmt_param->channel].config = *rmt_param;
+	return ESP_OK;
+} // rmt_config
+
+
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rx_buf_size, int intr_alloc_flags) {
+	if (mock_rmt[channel].installed) {
+		return ESP_ERR_INVALID_STATE;
+	}
+	mock_rmt[channel].installed = true;
+	return ESP_OK;
+} // rmt_driver_install
+
+
+esp_err_t rmt_driver_uninstall(rmt_channel_t channel) {
+	mock_rmt[channel].installed  = false;
+	mock_rmt[channel].translator = nullptr;
+	return ESP_OK;
+} // rmt_driver_uninstall
+
+
+esp_err_t rmt_set_mem_block_num(rmt_channel_t channel, uint8_t rmt_mem_num) {
+	mock_rmt[channel].config.mem_block_num = rmt_mem_num;
+	return ESP_OK;
+} // rmt_set_mem_block_num
+
+
+esp_err_t rmt_write_items(rmt_channel_t channel, const rmt_item32_t* rmt_item, int item_num, bool wait_tx_done) {
+	if (!mock_rmt[channel].installed) {
+		return ESP_ERR_INVALID_STATE;
+	}
+	startFrame(channel);
+	mock_rmt[channel].items.assign(rmt_item, rmt_item + item_num);
+	endFrame(channel);
+	return ESP_OK;
+} // rmt_write_items
+
+
+esp_err_t rmt_wait_tx_done(rmt_channel_t channel, uint32_t wait_time) {
+	return mock_rmt[channel].installed ? ESP_OK : ESP_ERR_INVALID_STATE;
+} // rmt_wait_tx_done
+
+
+esp_err_t rmt_translator_init(rmt_channel_t channel, sample_to_rmt_t fn) {
+	mock_rmt[channel].translator = fn;
+	return ESP_OK;
+} // rmt_translator_init
+
+
+esp_err_t rmt_write_sample(rmt_channel_t channel, const uint8_t* src, size_t src_size, bool wait_tx_done) {
+	mock_rmt_channel_t* rmt = &mock_rmt[channel];
+	if (!rmt->installed || rmt->translator == nullptr) {
+		return ESP_ERR_INVALID_STATE;
+	}
+
+	startFrame(channel);
+	size_t blockItems = rmt->config.mem_block_num * RMT_MEM_ITEM_NUM;
+	size_t wanted     = blockItems;
+	std::vector<rmt_item32_t> block(blockItems);
+	rmt->items.clear();
+	while (src_size > 0) {
+		size_t translated = 0;
+		size_t itemNum    = 0;
+		rmt->translator(src, block.data(), src_size, wanted, &translated, &itemNum);
+		if (translated == 0 || translated > src_size || itemNum > wanted) {
+			fprintf(stderr, "RMT translator of channel %d translated %d bytes into %d items out of %d wanted\n",
+				channel, (int) translated, (int) itemNum, (int) wanted);
+			abort();
+		}
+		rmt->items.insert(rmt->items.end(), block.begin(), block.begin() + itemNum);
+		src      += translated;
+		src_size -= translated;
+		wanted    = blockItems / 2;
+	}
+	endFrame(channel);
+	return ESP_OK;
+} // rmt_write_sample
+
+
+rmt_tx_end_callback_t rmt_register_tx_end_callback(rmt_tx_end_fn_t function, void* arg) {
+	rmt_tx_end_callback_t previous = s_txEndCallback;
+	s_txEndCallback.function = function;
+	s_txEndCallback.arg      = arg;
+	return previous;
+} // rmt_register_tx_end_callback
@@ -0,0 +1,88 @@
+/*
+ * Host mock of the SPI master driver, for a single device on each host.
+ */
+#include <math.h>
+#include <soc/soc.h>
+
+#include "mock.h"
+
+mock_spi_host_t mock_spi[3];
+
+struct spi_device_t {
+	spi_host_device_t host;
+	spi_transaction_t* done;  // Transaction not collected by spi_device_get_trans_result() yet.
+};
+
+static spi_device_t s_devices[3];
+
+
+double mock_spi_bit_ns(spi_host_device_t host) {
+	// The clock is APB_CLK_FREQ divided by an integer, the one closest to the requested clock.
+	int divider = (int) lround((double) APB_CLK_FREQ / mock_spi[host].device.clock_speed_hz);
+	return divider * 1e9 / APB_CLK_FREQ;
+} // mock_spi_bit_ns
+
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t* bus_config, int dma_chan) {
+	if (mock_spi[host].initialized) {
+		return ESP_ERR_INVALID_STATE;
+	}
+	mock_spi[host].bus         = *bus_config;
+	mock_spi[host].initialized = true;
+	return ESP_OK;
+} // spi_bus_initialize
+
+
+esp_err_t spi_bus_free(spi_host_device_t host) {
+	mock_spi[host].initialized = false;
+	return ESP_OK;
+} // spi_bus_free
+
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t* dev_config,
+		spi_device_handle_t* handle) {
+	if (!mock_spi[host].initialized) {
+		return ESP_ERR_INVALID_STATE;
+	}
+	mock_spi[host].device = *dev_config;
+	s_devices[host].host  = host;
+	s_devices[host].done  = nullptr;
+	*handle = &s_devices[host];
+	return ESP_OK;
+} // spi_bus_add_device
+
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle) {
+	return ESP_OK;
+} // spi_bus_remove_device
+
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t* trans_desc, TickType_t ticks_to_wait) {
+	mock_spi_host_t* spi = &mock_spi[handle->host];
+	if (handle->done != nullptr) {
+		// The queue has room for more, but the drivers always collect the previous result first.
+		return ESP_ERR_INVALID_STATE;
+	}
+	if (trans_desc->length % 8 != 0 || (int) trans_desc->length / 8 > spi->bus.max_transfer_sz) {
+		return ESP_ERR_INVALID_ARG;
+	}
+	const uint8_t* bytes = (const uint8_t*) trans_desc->tx_buffer;
+	spi->bytes.assign(bytes, bytes + trans_desc->length / 8);
+	spi->transactions++;
+	handle->done = trans_desc;
+	if (spi->device.post_cb != nullptr) {
+		spi->device.post_cb(trans_desc);
+	}
+	return ESP_OK;
+} // spi_device_queue_trans
+
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t** trans_desc,
+		TickType_t ticks_to_wait) {
+	if (handle->done == nullptr) {
+		return ESP_ERR_TIMEOUT;
+	}
+	*trans_desc  = handle->done;
+	handle->done = nullptr;
+	return ESP_OK;
+} // spi_device_get_trans_result
@@ -0,0 +1,323 @@
+/*
+ * Art-Net node, fed with packets sent over the loopback interface and rendering through the
+ * module: frames spread over several port-addresses, ArtSync and ArtPoll.
+ *
+ * The benchmarks replay frames to measure the packets handled per second, and the latency from
+ * the last packet of a frame to the start of the show() rendering it.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include <esp_timer.h>
+
+#include "artnet_config.h"
+#include "host_test.h"
+#include "loopback.h"
+#include "mock.h"
+#include "module_config.h"
+#include "waveform.h"
+
+static const uint16_t COUNT        = 200;  // 600 bytes, in 2 universes of 510 slots.
+static const uint16_t PORT_ADDRESS = CONFIG_ARTNET_UNIVERSE;
+static const int32_t  DEVICE_ID    = 7;
+
+static const uint8_t ARTNET_ID[8] = { 'A', 'r', 't', '-', 'N', 'e', 't', 0 };
+
+// Frames shown on the strip so far, by the render task of the module.
+static uint32_t s_shownFrames = 0;
+
+
+bool load_id_from_nvs(int32_t* device_id) {
+	*device_id = DEVICE_ID;
+	return true;
+} // load_id_from_nvs
+
+
+static std::vector<uint8_t> header(uint16_t opCode, size_t length) {
+	std::vector<uint8_t> packet(length, 0);
+	memcpy(&packet[0], ARTNET_ID, sizeof(ARTNET_ID));
+	packet[8]  = opCode;
+	packet[9]  = opCode >> 8;
+	packet[11] = 14;
+	return packet;
+} // header
+
+
+/**
+ * @brief An ArtDmx packet, its slots counting up from a value.
+ */
+static std::vector<uint8_t> dmxPacket(uint16_t portAddress, uint8_t sequence, uint16_t slots, uint8_t value) {
+	std::vector<uint8_t> packet = header(0x5000, 18 + slots);
+	packet[12] = sequence;
+	packet[14] = portAddress;
+	packet[15] = portAddress >> 8;
+	packet[16] = slots >> 8;
+	packet[17] = slots;
+	for (uint16_t i = 0; i < slots; i++) {
+		packet[18 + i] = value + i;
+	}
+	return packet;
+} // dmxPacket
+
+
+static std::vector<uint8_t> syncPacket() {
+	return header(0x5200, 14);
+} // syncPacket
+
+
+static std::vector<uint8_t> pollPacket() {
+	return header(0x2000, 14);
+} // pollPacket
+
+
+/**
+ * @brief The frame of 2 universes of slots counting up from values, from the first channel.
+ */
+static std::vector<uint8_t> expectedFrame(uint8_t first, uint8_t second) {
+	std::vector<uint8_t> frame(COUNT * 3);
+	for (size_t i = 0; i < frame.size(); i++) {
+		frame[i] = i < 510 ? first + i : second + (i - 510);
+	}
+	return frame;
+} // expectedFrame
+
+
+static void send(const std::vector<uint8_t>& packet) {
+	CHECK(sendDatagram(ARTNET_PORT, packet));
+} // send
+
+
+/**
+ * @brief Wait for the render task to show the next frame, and decode it from the line.
+ */
+static bool waitShownFrame(std::vector<uint8_t>* pFrame) {
+	if (!mock_rmt_wait_frames(RMT_CHANNEL_0, s_shownFrames + 1, 1000)) {
+		return false;
+	}
+	s_shownFrames++;
+	decoded_t decoded;
+	waveform_t waveform = waveformFromItems(mock_rmt[RMT_CHANNEL_0].items, mock_rmt_tick_ns(RMT_CHANNEL_0));
+	if (!decodeWaveform(waveform, getBitWindow(WS2812_TYPE_WS2812), &decoded)) {
+		fprintf(stderr, "%s\n", decoded.error.c_str());
+		return false;
+	}
+	*pFrame = decoded.bytes;
+	return true;
+} // waitShownFrame
+
+
+static void testFrames() {
+	std::vector<uint8_t> frame;
+	artnet_stats_t stats;
+	uint32_t posted = get_posted_commands();
+
+	// A frame is posted once all its universes are there, and shown at once.
+	send(dmxPacket(PORT_ADDRESS, 1, 512, 0));
+	CHECK_EQUAL(posted, get_posted_commands());
+	send(dmxPacket(PORT_ADDRESS + 1, 1, 512, 100));
+	CHECK_EQUAL(posted + 1, get_posted_commands());
+	CHECK(waitShownFrame(&frame));
+	CHECK(frame == expectedFrame(0, 100));
+
+	// Older packets are discarded, a sequence of 0 is always taken.
+	send(dmxPacket(PORT_ADDRESS, 2, 512, 1));
+	send(dmxPacket(PORT_ADDRESS + 1, 1, 512, 9));
+	CHECK_EQUAL(posted + 1, get_posted_commands());
+	send(dmxPacket(PORT_ADDRESS + 1, 0, 512, 2));
+	CHECK_EQUAL(posted + 2, get_posted_commands());
+	CHECK(waitShownFrame(&frame));
+	CHECK(frame == expectedFrame(1, 2));
+
+	// Other port-addresses are ignored.
+	send(dmxPacket(PORT_ADDRESS + 2, 3, 512, 3));
+	send(dmxPacket(PORT_ADDRESS + 0x100, 3, 512, 3));
+	CHECK_EQUAL(posted + 2, get_posted_commands());
+
+	get_artnet_stats(&stats);
+	CHECK_EQUAL(4, stats.packets);
+	CHECK_EQUAL(2, stats.frames);
+	CHECK_EQUAL(0, stats.dropped);
+	CHECK_EQUAL(1, stats.out_of_sequence);
+} // testFrames
+
+
+static void testSync() {
+	std::vector<uint8_t> frame;
+	artnet_stats_t stats;
+	uint32_t posted = get_posted_commands();
+
+	// Once ArtSync packets come, the frames wait for them.
+	send(syncPacket());
+	send(dmxPacket(PORT_ADDRESS, 10, 512, 10));
+	send(dmxPacket(PORT_ADDRESS + 1, 10, 512, 11));
+	CHECK_EQUAL(posted, get_posted_commands());
+	send(syncPacket());
+	CHECK_EQUAL(posted + 1, get_posted_commands());
+	CHECK(waitShownFrame(&frame));
+	CHECK(frame == expectedFrame(10, 11));
+
+	// A frame missing some universes is dropped, the strip keeps the previous frame.
+	send(dmxPacket(PORT_ADDRESS + 1, 11, 512, 12));
+	send(syncPacket());
+	CHECK_EQUAL(posted + 1, get_posted_commands());
+
+	get_artnet_stats(&stats);
+	CHECK_EQUAL(3, stats.syncs);
+	CHECK_EQUAL(1, stats.dropped);
+} // testSync
+
+
+/**
+ * @brief Whether the frame buffer is free, for instance for MQTT frames.
+ */
+static bool isFrameBufferFree() {
+	size_t size;
+	if (acquire_frame_buffer(&size) == nullptr) {
+		return false;
+	}
+	release_frame_buffer();
+	return true;
+} // isFrameBufferFree
+
+
+/**
+ * @brief A frame waiting for its other universes or for its ArtSync gives the frame buffer back
+ * after a while, even when no more packets come.
+ */
+static void testExpiry() {
+	artnet_stats_t before;
+	get_artnet_stats(&before);
+	uint32_t posted = get_posted_commands();
+	send(dmxPacket(PORT_ADDRESS, 20, 512, 20));
+	CHECK(!isFrameBufferFree());
+	for (int i = 0; i < 100 && !isFrameBufferFree(); i++) {
+		vTaskDelay(pdMS_TO_TICKS(10));
+	}
+	CHECK(isFrameBufferFree());
+	CHECK_EQUAL(posted, get_posted_commands());
+	artnet_stats_t after;
+	get_artnet_stats(&after);
+	CHECK_EQUAL(1, after.dropped - before.dropped);
+} // testExpiry
+
+
+/**
+ * @brief An ArtPoll is answered with an ArtPollReply for each port-address.
+ */
+static void testPoll() {
+	mock_udp_sent.clear();
+	uint32_t handled = mock_netconn_handled();
+	postDatagram(ARTNET_PORT, pollPacket());
+	// The replies go to the Art-Net port of the sender, the node itself on the loopback.
+	CHECK(mock_netconn_wait_handled(handled + 3, 1000));
+	CHECK_EQUAL(2, mock_udp_sent.size());
+	for (size_t i = 0; i < mock_udp_sent.size(); i++) {
+		const std::vector<uint8_t>& reply = mock_udp_sent[i].bytes;
+		CHECK_EQUAL(ARTNET_PORT, mock_udp_sent[i].port);
+		CHECK_EQUAL(239, reply.size());
+		if (reply.size() != 239) {
+			continue;
+		}
+		CHECK(memcmp(&reply[0], ARTNET_ID, sizeof(ARTNET_ID)) == 0);
+		CHECK_EQUAL(0x2100, reply[8] | reply[9] << 8);
+		CHECK(reply[10] == 127 && reply[11] == 0 && reply[12] == 0 && reply[13] == 1);
+		CHECK_EQUAL(ARTNET_PORT, reply[14] | reply[15] << 8);
+		CHECK_EQUAL((PORT_ADDRESS + i) >> 8, reply[18]);
+		CHECK_EQUAL(((PORT_ADDRESS + i) >> 4) & 0x0f, reply[19]);
+		CHECK(strcmp((const char*) &reply[26], "PixLed 7") == 0);
+		CHECK_EQUAL(1, reply[173]);
+		CHECK_EQUAL((PORT_ADDRESS + i) & 0x0f, reply[190]);
+		CHECK_EQUAL(i + 1, reply[211]);
+	}
+	artnet_stats_t stats;
+	get_artnet_stats(&stats);
+	CHECK_EQUAL(1, stats.polls);
+} // testPoll
+
+
+/**
+ * @brief Packets handled per second, replaying synchronized frames with a bounded number of
+ * packets in flight, so that the socket never drops any.
+ */
+static void benchmarkThroughput(uint32_t frames) {
+	const uint32_t window = 32;
+	std::vector<std::vector<uint8_t>> packets;
+	packets.push_back(dmxPacket(PORT_ADDRESS, 0, 512, 0));
+	packets.push_back(dmxPacket(PORT_ADDRESS + 1, 0, 512, 0));
+	packets.push_back(syncPacket());
+
+	uint32_t first = mock_netconn_handled();
+	uint32_t count = frames * packets.size();
+	int64_t  start = esp_timer_get_time();
+	for (uint32_t i = 0; i < count; i++) {
+		if (i >= window && !mock_netconn_wait_handled(first + i - window, 1000)) {
+			fprintf(stderr, "Packet %u was not handled\n", i - window);
+			s_failures++;
+			return;
+		}
+		postDatagram(ARTNET_PORT, packets[i % packets.size()]);
+	}
+	CHECK(mock_netconn_wait_handled(first + count, 1000));
+	int64_t elapsed = esp_timer_get_time() - start;
+	printf("%-32s %6u packets: %8.0f packets/s\n", "ArtDmx + ArtSync replay", count, count * 1e6 / elapsed);
+} // benchmarkThroughput
+
+
+/**
+ * @brief Time from sending the ArtSync of a frame to the start of the show() rendering it.
+ *
+ * The render task picks the frames up at its refresh period, which bounds the latency.
+ */
+static void benchmarkLatency(uint32_t frames) {
+	std::vector<int64_t> handledUs;
+	std::vector<int64_t> shownUs;
+	// Skip the frames shown by the throughput replay.
+	vTaskDelay(pdMS_TO_TICKS(100));
+	s_shownFrames = mock_rmt[RMT_CHANNEL_0].frames;
+	for (uint32_t frame = 0; frame < frames; frame++) {
+		send(dmxPacket(PORT_ADDRESS, 0, 512, frame));
+		send(dmxPacket(PORT_ADDRESS + 1, 0, 512, frame));
+		int64_t start = esp_timer_get_time();
+		send(syncPacket());
+		handledUs.push_back(esp_timer_get_time() - start);
+		std::vector<uint8_t> shown;
+		if (!waitShownFrame(&shown)) {
+			fprintf(stderr, "Frame %u was not shown\n", frame);
+			s_failures++;
+			return;
+		}
+		shownUs.push_back(mock_rmt[RMT_CHANNEL_0].startUs - start);
+	}
+	std::sort(handledUs.begin(), handledUs.end());
+	std::sort(shownUs.begin(), shownUs.end());
+	printf("%-32s %6u frames: median %6lld us, max %6lld us\n", "Last packet handled", frames,
+		(long long) handledUs[frames / 2], (long long) handledUs[frames - 1]);
+	printf("%-32s %6u frames: median %6lld us, max %6lld us (render period %u us)\n", "Last packet to show()",
+		frames, (long long) shownUs[frames / 2], (long long) shownUs[frames - 1],
+		(unsigned) (pdMS_TO_TICKS(1000 / CONFIG_STRIP_RENDER_FPS) * 1000000 / configTICK_RATE_HZ));
+} // benchmarkLatency
+
+
+int main(int argc, char** argv) {
+	save_led_number_to_nvs(COUNT);
+	init_strip();
+	// Switched on to black, the strip is only shown when frames come.
+	handle_switch("ON");
+	start_strip_render();
+	start_artnet();
+	if (!mock_netconn_wait_bound(ARTNET_PORT, 1000)) {
+		fprintf(stderr, "The node did not bind port %d\n", ARTNET_PORT);
+		return 1;
+	}
+	testFrames();
+	testSync();
+	testExpiry();
+	testPoll();
+	if (isBenchmark(argc, argv)) {
+		benchmarkThroughput(2000);
+		benchmarkLatency(100);
+	}
+	stop_artnet();
+	return finishTest("test_artnet");
+} // main
@@ -0,0 +1,187 @@
+/*
+ * Color orders, resolved once by setColorOrder() into the shifts of the pixel words, compared
+ * with looking up the channel of each order letter for every pixel.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "WS2812.h"
+#include "host_test.h"
+#include "mock.h"
+#include "waveform.h"
+
+
+static uint8_t getChannelValueByType(char type, pixel_t pixel) {
+	switch (type) {
+		case 'r':
+		case 'R':
+			return pixel.red;
+		case 'g':
+		case 'G':
+			return pixel.green;
+		case 'b':
+		case 'B':
+			return pixel.blue;
+		case 'w':
+		case 'W':
+			return pixel.white;
+		default:
+			return 0;
+	}
+} // getChannelValueByType
+
+
+/**
+ * @brief Wire levels of pixels, dispatching on the color order for every channel.
+ */
+static void orderReference(const char* order, uint8_t channelCount, const uint8_t* levels, const pixel_t* pixels,
+		uint16_t count, uint8_t* pBytes) {
+	for (uint16_t i = 0; i < count; i++) {
+		for (uint8_t c = 0; c < channelCount; c++) {
+			*pBytes++ = levels[getChannelValueByType(order[c], pixels[i])];
+		}
+	}
+} // orderReference
+
+
+static const uint8_t* identityLevels() {
+	static uint8_t levels[256];
+	for (int i = 0; i < 256; i++) {
+		levels[i] = i;
+	}
+	return levels;
+} // identityLevels
+
+
+static std::vector<pixel_t> randomPixels(uint16_t count, bool white) {
+	std::vector<pixel_t> pixels(count);
+	for (uint16_t i = 0; i < count; i++) {
+		pixels[i].red   = rand();
+		pixels[i].green = rand();
+		pixels[i].blue  = rand();
+		pixels[i].white = white ? rand() : 0;
+	}
+	return pixels;
+} // randomPixels
+
+
+static bool samePixel(pixel_t a, pixel_t b, bool white) {
+	return a.red == b.red && a.green == b.green && a.blue == b.blue && (!white || a.white == b.white);
+} // samePixel
+
+
+static void testParse() {
+	uint8_t offsets[4];
+	CHECK(WS2812::parseColorOrder("GRB", offsets));
+	CHECK_EQUAL(offsetof(pixel_t, green), offsets[0]);
+	CHECK_EQUAL(offsetof(pixel_t, red), offsets[1]);
+	CHECK_EQUAL(offsetof(pixel_t, blue), offsets[2]);
+	CHECK(WS2812::parseColorOrder("bgr", offsets));
+	CHECK_EQUAL(offsetof(pixel_t, blue), offsets[0]);
+	CHECK(WS2812::parseColorOrder("WRGB", offsets, 4));
+	CHECK_EQUAL(offsetof(pixel_t, white), offsets[0]);
+
+	CHECK(!WS2812::parseColorOrder(nullptr, offsets));
+	CHECK(!WS2812::parseColorOrder("GR", offsets));
+	CHECK(!WS2812::parseColorOrder("GRBW", offsets));
+	CHECK(!WS2812::parseColorOrder("GRW", offsets));
+	CHECK(!WS2812::parseColorOrder("GGB", offsets));
+	CHECK(!WS2812::parseColorOrder("GRX", offsets));
+	CHECK(!WS2812::parseColorOrder("GRB", offsets, 4));
+	CHECK(!WS2812::parseColorOrder("GRBB", offsets, 4));
+} // testParse
+
+
+/**
+ * @brief Every order of the channels of a type, on pixels set before and after the order.
+ */
+static void testOrders(ws2812_type_t type) {
+	const uint16_t count = 20;
+	WS2812* strip = new WS2812(GPIO_NUM_16, count, RMT_CHANNEL_0, WS2812_OUTPUT_RMT_STREAM, 0, type);
+	strip->setWhiteExtraction(false);
+	const uint8_t channelCount = strip->getChannelCount();
+	const bool    white        = channelCount == 4;
+	std::vector<pixel_t> pixels = randomPixels(count, white);
+	for (uint16_t i = 0; i < count; i++) {
+		strip->setPixel(i, pixels[i]);
+	}
+
+	std::string order = white ? "BGRW" : "BGR";
+	std::sort(order.begin(), order.end());
+	do {
+		// Pixels set in the previous order keep their colors.
+		strip->setColorOrder((char*) order.c_str());
+		pixels[3] = randomPixels(1, white)[0];
+		strip->setPixel(3, pixels[3]);
+		strip->show();
+
+		std::vector<uint8_t> expected(count * channelCount);
+		orderReference(order.c_str(), channelCount, identityLevels(), pixels.data(), count, expected.data());
+		decoded_t decoded;
+		waveform_t waveform = waveformFromItems(mock_rmt[RMT_CHANNEL_0].items, mock_rmt_tick_ns(RMT_CHANNEL_0));
+		CHECK(decodeWaveform(waveform, getBitWindow(type), &decoded));
+		if (decoded.bytes != expected) {
+			fprintf(stderr, "Wrong bytes for the %s order\n", order.c_str());
+			s_failures++;
+		}
+		for (uint16_t i = 0; i < count; i++) {
+			CHECK(samePixel(pixels[i], strip->getPixel(i), white));
+		}
+	} while (std::next_permutation(order.begin(), order.end()));
+
+	// An invalid order keeps the previous one.
+	std::vector<rmt_item32_t> items = mock_rmt[RMT_CHANNEL_0].items;
+	strip->setColorOrder((char*) (white ? "GRBR" : "GRG"));
+	strip->show();
+	CHECK(items.size() == mock_rmt[RMT_CHANNEL_0].items.size());
+	CHECK(std::equal(items.begin(), items.end(), mock_rmt[RMT_CHANNEL_0].items.begin(),
+		[](const rmt_item32_t& a, const rmt_item32_t& b) { return a.val == b.val; }));
+	delete strip;
+	mock_reset();
+} // testOrders
+
+
+static void benchmarkOrder(uint16_t count) {
+	std::vector<pixel_t> pixels = randomPixels(count, false);
+	std::vector<uint8_t> bytes(count * 3);
+	const uint8_t* levels = identityLevels();
+	double reference = benchmarkNs(200, [&]() {
+		orderReference("GRB", 3, levels, pixels.data(), count, bytes.data());
+	});
+
+	// The strip applies the order when the pixels are set.  Its encode time also covers the run
+	// detection and the power sums, which the reference does not do.
+	WS2812* strip = new WS2812(GPIO_NUM_16, count, RMT_CHANNEL_0, WS2812_OUTPUT_RMT_STREAM);
+	double   copy     = 0;
+	uint64_t encodeUs = 0;
+	const uint32_t frames = 200;
+	for (uint32_t frame = 0; frame < frames; frame++) {
+		pixels[frame % count].red++;
+		copy += benchmarkNs(1, [&]() { strip->copyFrom(pixels.data(), count); });
+		strip->show();
+		ws2812_stats_t stats;
+		strip->getStats(&stats);
+		encodeUs += stats.lastEncodeUs;
+	}
+	double encode = encodeUs * 1000.0 / frames;
+	printf("%-28s %6u pixels: %6.2f ns/pixel\n", "Order looked up per channel", count, reference / count);
+	printf("%-28s %6u pixels: %6.2f ns/pixel (%.2f to set, %.2f to encode)\n", "Order resolved once", count,
+		(copy / frames + encode) / count, copy / frames / count, encode / count);
+	delete strip;
+	mock_reset();
+} // benchmarkOrder
+
+
+int main(int argc, char** argv) {
+	srand(1);
+	testParse();
+	testOrders(WS2812_TYPE_WS2812);
+	testOrders(WS2812_TYPE_SK6812_RGBW);
+	if (isBenchmark(argc, argv)) {
+		benchmarkOrder(10000);
+	}
+	return finishTest("test_color_order");
+} // main
@@ -0,0 +1,272 @@
+/*
+ * E1.31 receiver, fed with packets sent over the loopback interface: frames spread over several
+ * universes, synchronization, sequence numbers and frames missing some universes.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "dmx_harness.h"
+#include "e131_config.h"
+#include "host_test.h"
+#include "loopback.h"
+#include "mock.h"
+
+static const uint16_t COUNT    = 200;  // 600 bytes, in 2 universes of 510 slots.
+static const uint16_t UNIVERSE = CONFIG_E131_UNIVERSE;
+
+static const uint8_t ACN_IDENTIFIER[12] = { 'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0 };
+
+
+static void write16(uint8_t* data, uint16_t value) {
+	data[0] = value >> 8;
+	data[1] = value;
+} // write16
+
+
+static void write32(uint8_t* data, uint32_t value) {
+	write16(data, value >> 16);
+	write16(data + 2, value);
+} // write32
+
+
+/**
+ * @brief Flags and length of a PDU starting at an offset of a packet.
+ */
+static void writePDULength(std::vector<uint8_t>& packet, size_t offset) {
+	write16(&packet[offset], 0x7000 | (packet.size() - offset));
+} // writePDULength
+
+
+/**
+ * @brief An E1.31 data packet, its slots counting up from a value.
+ */
+static std::vector<uint8_t> dataPacket(uint16_t universe, uint8_t sequence, uint16_t slots, uint8_t value,
+		uint16_t syncAddress = 0, uint8_t options = 0) {
+	std::vector<uint8_t> packet(126 + slots, 0);
+	write16(&packet[0], 0x0010);
+	memcpy(&packet[4], ACN_IDENTIFIER, sizeof(ACN_IDENTIFIER));
+	writePDULength(packet, 16);
+	write32(&packet[18], 0x00000004);
+	memcpy(&packet[22], "host test cid...", 16);
+	writePDULength(packet, 38);
+	write32(&packet[40], 0x00000002);
+	strcpy((char*) &packet[44], "host test");
+	packet[108] = 100;
+	write16(&packet[109], syncAddress);
+	packet[111] = sequence;
+	packet[112] = options;
+	write16(&packet[113], universe);
+	writePDULength(packet, 115);
+	packet[117] = 0x02;
+	packet[118] = 0xa1;
+	write16(&packet[121], 1);
+	write16(&packet[123], slots + 1);
+	for (uint16_t i = 0; i < slots; i++) {
+		packet[126 + i] = value + i;
+	}
+	return packet;
+} // dataPacket
+
+
+static std::vector<uint8_t> syncPacket(uint8_t sequence, uint16_t syncAddress) {
+	std::vector<uint8_t> packet(49, 0);
+	write16(&packet[0], 0x0010);
+	memcpy(&packet[4], ACN_IDENTIFIER, sizeof(ACN_IDENTIFIER));
+	writePDULength(packet, 16);
+	write32(&packet[18], 0x00000008);
+	memcpy(&packet[22], "host test cid...", 16);
+	writePDULength(packet, 38);
+	write32(&packet[40], 0x00000001);
+	packet[44] = sequence;
+	write16(&packet[45], syncAddress);
+	return packet;
+} // syncPacket
+
+
+/**
+ * @brief The frame of 2 universes of slots counting up from values, from the first channel.
+ */
+static std::vector<uint8_t> expectedFrame(uint8_t first, uint8_t second) {
+	std::vector<uint8_t> frame(COUNT * 3);
+	for (size_t i = 0; i < frame.size(); i++) {
+		frame[i] = i < 510 ? first + i : second + (i - 510);
+	}
+	return frame;
+} // expectedFrame
+
+
+static void send(const std::vector<uint8_t>& packet) {
+	CHECK(sendDatagram(E131_PORT, packet));
+} // send
+
+
+static bool hasGroup(uint16_t universe) {
+	uint32_t group = 239 | 255 << 8 | (universe >> 8) << 16 | (uint32_t) (universe & 0xff) << 24;
+	for (size_t i = 0; i < mock_udp_groups.size(); i++) {
+		if (mock_udp_groups[i] == group) {
+			return true;
+		}
+	}
+	return false;
+} // hasGroup
+
+
+static void testFrames() {
+	std::vector<std::vector<uint8_t>> frames;
+	e131_stats_t stats;
+
+	// A frame is posted once all its universes are there.
+	send(dataPacket(UNIVERSE, 1, 512, 0));
+	CHECK(takePostedFrames().empty());
+	send(dataPacket(UNIVERSE + 1, 1, 512, 100));
+	frames = takePostedFrames();
+	CHECK(frames.size() == 1 && frames[0] == expectedFrame(0, 100));
+
+	// Older packets are discarded, the universes of the frame still make a frame.
+	send(dataPacket(UNIVERSE, 2, 512, 1));
+	send(dataPacket(UNIVERSE, 1, 512, 9));
+	send(dataPacket(UNIVERSE + 1, 2, 512, 2));
+	frames = takePostedFrames();
+	CHECK(frames.size() == 1 && frames[0] == expectedFrame(1, 2));
+
+	// A universe received twice drops the frame, which starts again.
+	send(dataPacket(UNIVERSE, 3, 512, 3));
+	send(dataPacket(UNIVERSE, 4, 512, 4));
+	CHECK(isFrameBufferHeld());
+	send(dataPacket(UNIVERSE + 1, 4, 512, 5));
+	frames = takePostedFrames();
+	CHECK(frames.size() == 1 && frames[0] == expectedFrame(4, 5));
+
+	// Preview data, other start codes and other universes are ignored.
+	send(dataPacket(UNIVERSE, 5, 512, 6, 0, 0x80));
+	send(dataPacket(UNIVERSE + 2, 5, 512, 6));
+	std::vector<uint8_t> alternate = dataPacket(UNIVERSE, 6, 512, 6);
+	alternate[125] = 0xdd;
+	send(alternate);
+	CHECK(!isFrameBufferHeld());
+
+	// Packets split over several pbufs.
+	mock_pbuf_size = 100;
+	send(dataPacket(UNIVERSE, 7, 512, 7));
+	send(dataPacket(UNIVERSE + 1, 7, 512, 8));
+	frames = takePostedFrames();
+	CHECK(frames.size() == 1 && frames[0] == expectedFrame(7, 8));
+	mock_pbuf_size = 1600;
+
+	get_e131_stats(&stats);
+	CHECK_EQUAL(9, stats.packets);
+	CHECK_EQUAL(4, stats.frames);
+	CHECK_EQUAL(1, stats.dropped);
+	CHECK_EQUAL(1, stats.out_of_sequence);
+	CHECK(hasGroup(UNIVERSE));
+	CHECK(hasGroup(UNIVERSE + 1));
+	reset_e131_stats();
+} // testFrames
+
+
+static void testSync() {
+	std::vector<std::vector<uint8_t>> frames;
+	e131_stats_t stats;
+
+	// The universes of a synchronized frame wait for the synchronization packet.
+	send(dataPacket(UNIVERSE, 10, 512, 10, 7000));
+	send(dataPacket(UNIVERSE + 1, 10, 512, 11, 7000));
+	CHECK(takePostedFrames().empty());
+	CHECK(hasGroup(7000));
+	send(syncPacket(1, 7001));
+	CHECK(takePostedFrames().empty());
+	send(syncPacket(2, 7000));
+	frames = takePostedFrames();
+	CHECK(frames.size() == 1 && frames[0] == expectedFrame(10, 11));
+
+	// A frame missing some universes is dropped on synchronization, the strip keeps the previous
+	// frame.
+	send(dataPacket(UNIVERSE, 11, 512, 12, 7000));
+	send(syncPacket(3, 7000));
+	CHECK(takePostedFrames().empty());
+	CHECK(!isFrameBufferHeld());
+
+	// Without a frame buffer, the frames are dropped.
+	setFrameBufferAvailable(false);
+	send(dataPacket(UNIVERSE, 12, 512, 13, 7000));
+	send(dataPacket(UNIVERSE + 1, 12, 512, 14, 7000));
+	send(syncPacket(4, 7000));
+	CHECK(takePostedFrames().empty());
+	setFrameBufferAvailable(true);
+
+	// Back to unsynchronized frames.
+	send(dataPacket(UNIVERSE, 13, 512, 15));
+	send(dataPacket(UNIVERSE + 1, 13, 512, 16));
+	frames = takePostedFrames();
+	CHECK(frames.size() == 1 && frames[0] == expectedFrame(15, 16));
+
+	get_e131_stats(&stats);
+	CHECK_EQUAL(7, stats.packets);
+	CHECK_EQUAL(2, stats.frames);
+	CHECK_EQUAL(2, stats.dropped);
+	CHECK_EQUAL(4, stats.syncs);
+} // testSync
+
+
+/**
+ * @brief Only the group of the current synchronization address stays joined.
+ */
+static void testSyncGroups() {
+	send(dataPacket(UNIVERSE, 14, 512, 0, 7001));
+	CHECK(hasGroup(7001));
+	CHECK(!hasGroup(7000));
+	send(dataPacket(UNIVERSE, 15, 512, 0, 7002));
+	CHECK(!hasGroup(7001));
+	CHECK(hasGroup(7002));
+	send(dataPacket(UNIVERSE, 16, 512, 0));
+	send(dataPacket(UNIVERSE + 1, 16, 512, 0));
+	CHECK(!hasGroup(7002));
+	CHECK_EQUAL(2, mock_udp_groups.size());
+	CHECK_EQUAL(1, takePostedFrames().size());
+} // testSyncGroups
+
+
+/**
+ * @brief A frame missing some universes gives the frame buffer back after a while, even when no
+ * more packets come.
+ */
+static void testExpiry() {
+	e131_stats_t before;
+	get_e131_stats(&before);
+	send(dataPacket(UNIVERSE, 20, 512, 20));
+	CHECK(isFrameBufferHeld());
+	for (int i = 0; i < 100 && isFrameBufferHeld(); i++) {
+		vTaskDelay(pdMS_TO_TICKS(10));
+	}
+	CHECK(!isFrameBufferHeld());
+	CHECK(takePostedFrames().empty());
+	e131_stats_t after;
+	get_e131_stats(&after);
+	CHECK_EQUAL(1, after.dropped - before.dropped);
+
+	// The next frame is whole again.
+	send(dataPacket(UNIVERSE, 21, 512, 21));
+	send(dataPacket(UNIVERSE + 1, 21, 512, 22));
+	std::vector<std::vector<uint8_t>> frames = takePostedFrames();
+	CHECK(frames.size() == 1 && frames[0] == expectedFrame(21, 22));
+} // testExpiry
+
+
+int main(int argc, char** argv) {
+	initStrip(WS2812_TYPE_WS2812, COUNT);
+	start_e131();
+	if (!mock_netconn_wait_bound(E131_PORT, 1000)) {
+		fprintf(stderr, "The receiver did not bind port %d\n", E131_PORT);
+		return 1;
+	}
+	testFrames();
+	testSync();
+	testSyncGroups();
+	testExpiry();
+	stop_e131();
+	CHECK(mock_udp_groups.empty());
+	CHECK(!isFrameBufferHeld());
+	deleteStrip();
+	return finishTest("test_e131");
+} // main
@@ -0,0 +1,204 @@
+/*
+ * RMT items of the table driven encoder, compared with the items of a bit by bit encoder as the
+ * driver used to build them.
+ */
+#include <stdlib.h>
+#include <vector>
+
+#include "WS2812.h"
+#include "host_test.h"
+#include "mock.h"
+
+typedef struct {
+	ws2812_type_t type;
+	const char*   order;
+	uint16_t      t0h;  // Nominal timings in ns.
+	uint16_t      t0l;
+	uint16_t      t1h;
+	uint16_t      t1l;
+} reference_t;
+
+static const reference_t REFERENCES[] = {
+	{ WS2812_TYPE_WS2812,      "GRB",  400, 800,  1000, 600 },
+	{ WS2812_TYPE_WS2811,      "RGB",  250, 1000, 600,  650 },
+	{ WS2812_TYPE_WS2813,      "GRB",  350, 800,  800,  350 },
+	{ WS2812_TYPE_SK6812,      "GRB",  300, 900,  600,  600 },
+	{ WS2812_TYPE_SK6812_RGBW, "GRBW", 300, 900,  600,  600 },
+};
+
+
+/**
+ * @brief Ticks of 100ns of a duration in ns, rounded to the nearest.
+ */
+static uint16_t toTicks(uint16_t ns) {
+	return (ns + 50) / 100;
+} // toTicks
+
+
+static uint8_t getChannel(pixel_t pixel, char channel) {
+	switch (channel) {
+		case 'R': return pixel.red;
+		case 'G': return pixel.green;
+		case 'B': return pixel.blue;
+		default:  return pixel.white;
+	}
+} // getChannel
+
+
+/**
+ * @brief Encode pixels one bit at a time, looking up each channel of the color order.
+ */
+static void encodeReference(const reference_t* reference, const std::vector<pixel_t>& pixels,
+		rmt_item32_t* pItem) {
+	for (size_t i = 0; i < pixels.size(); i++) {
+		for (const char* channel = reference->order; *channel != 0; channel++) {
+			uint8_t value = getChannel(pixels[i], *channel);
+			for (uint8_t mask = 0x80; mask != 0; mask >>= 1) {
+				pItem->level0    = 1;
+				pItem->duration0 = toTicks((value & mask) ? reference->t1h : reference->t0h);
+				pItem->level1    = 0;
+				pItem->duration1 = toTicks((value & mask) ? reference->t1l : reference->t0l);
+				pItem++;
+			}
+		}
+	}
+} // encodeReference
+
+
+static std::vector<pixel_t> randomPixels(uint16_t count, bool white) {
+	std::vector<pixel_t> pixels(count);
+	for (uint16_t i = 0; i < count; i++) {
+		pixels[i].red   = rand();
+		pixels[i].green = rand();
+		pixels[i].blue  = rand();
+		pixels[i].white = white ? rand() : 0;
+	}
+	return pixels;
+} // randomPixels
+
+
+static bool sameItems(const std::vector<rmt_item32_t>& expected, const std::vector<rmt_item32_t>& actual) {
+	if (expected.size() != actual.size()) {
+		fprintf(stderr, "%u items instead of %u\n", (unsigned) actual.size(), (unsigned) expected.size());
+		return false;
+	}
+	for (size_t i = 0; i < expected.size(); i++) {
+		if (expected[i].val != actual[i].val) {
+			fprintf(stderr, "item %u is 0x%08x instead of 0x%08x\n", (unsigned) i, actual[i].val, expected[i].val);
+			return false;
+		}
+	}
+	return true;
+} // sameItems
+
+
+static void testItemStream(ws2812_output_t output) {
+	const uint16_t count = 64;
+	for (size_t r = 0; r < sizeof(REFERENCES) / sizeof(REFERENCES[0]); r++) {
+		const reference_t* reference = &REFERENCES[r];
+		WS2812* strip = new WS2812(GPIO_NUM_16, count, RMT_CHANNEL_0, output, 0, reference->type);
+		strip->setWhiteExtraction(false);
+		std::vector<pixel_t> pixels = randomPixels(count, strip->getChannelCount() == 4);
+		// Every nibble value on every channel.
+		for (uint16_t i = 0; i < 16; i++) {
+			pixels[i].red = pixels[i].green = pixels[i].blue = i * 0x11;
+			pixels[i].white = strip->getChannelCount() == 4 ? 0xff - i * 0x11 : 0;
+		}
+		for (uint16_t i = 0; i < count; i++) {
+			strip->setPixel(i, pixels[i]);
+		}
+		strip->show();
+
+		std::vector<rmt_item32_t> expected(count * strip->getChannelCount() * 8);
+		encodeReference(reference, pixels, expected.data());
+		CHECK(sameItems(expected, mock_rmt[RMT_CHANNEL_0].items));
+		delete strip;
+		mock_reset();
+	}
+} // testItemStream
+
+
+/**
+ * @brief A dithered frame dimmed by the power limit is sent as if the scale had been set before
+ * it, its dithering errors advancing once.
+ */
+static void testDitheredPowerLimit() {
+	const uint16_t count = 64;
+	std::vector<pixel_t> pixels = randomPixels(count, false);
+	WS2812* limited = new WS2812(GPIO_NUM_16, count, RMT_CHANNEL_0, WS2812_OUTPUT_RMT);
+	WS2812* scaled  = new WS2812(GPIO_NUM_17, count, RMT_CHANNEL_1, WS2812_OUTPUT_RMT);
+	for (WS2812* strip : { limited, scaled }) {
+		// Levels with fractional bits before the scale drops too.
+		strip->setGamma(2.2);
+		strip->setPowerLimit(500);
+		strip->setDithering(true);
+		for (uint16_t i = 0; i < count; i++) {
+			strip->setPixel(i, pixels[i]);
+		}
+	}
+	// The scaled strip starts from the scale the limited one drops to on its first frame, with
+	// fresh dithering errors.
+	scaled->show();
+	scaled->setDithering(false);
+	scaled->setDithering(true);
+	CHECK(scaled->getPowerScale() < 256);
+
+	for (int frame = 0; frame < 16; frame++) {
+		limited->show();
+		scaled->show();
+		CHECK(sameItems(mock_rmt[RMT_CHANNEL_1].items, mock_rmt[RMT_CHANNEL_0].items));
+	}
+	CHECK_EQUAL(scaled->getPowerScale(), limited->getPowerScale());
+	delete limited;
+	delete scaled;
+	mock_reset();
+} // testDitheredPowerLimit
+
+
+/**
+ * @brief Encode time of whole frames, from the strip statistics.
+ */
+static void benchmarkEncode(ws2812_output_t output, const char* name, uint16_t count) {
+	int channel = output == WS2812_OUTPUT_SPI ? (int) HSPI_HOST : (int) RMT_CHANNEL_0;
+	WS2812* strip = new WS2812(GPIO_NUM_16, count, channel, output);
+	std::vector<pixel_t> pixels = randomPixels(count, false);
+	const uint32_t frames = 200;
+	uint64_t encodeUs = 0;
+	for (uint32_t frame = 0; frame < frames; frame++) {
+		// Every pixel changes, and differs from the next one, so every pixel is encoded.
+		for (uint16_t i = 0; i < count; i++) {
+			pixels[i].red += 1;
+			strip->setPixel(i, pixels[i]);
+		}
+		strip->show();
+		ws2812_stats_t stats;
+		strip->getStats(&stats);
+		encodeUs += stats.lastEncodeUs;
+	}
+	printf("%-20s %6u pixels: %6.2f ns/pixel\n", name, count, encodeUs * 1000.0 / frames / count);
+	delete strip;
+	mock_reset();
+} // benchmarkEncode
+
+
+static void benchmarkReference(uint16_t count) {
+	std::vector<pixel_t> pixels = randomPixels(count, false);
+	std::vector<rmt_item32_t> items(count * 24);
+	double ns = benchmarkNs(200, [&]() { encodeReference(&REFERENCES[0], pixels, items.data()); });
+	printf("%-20s %6u pixels: %6.2f ns/pixel\n", "bit by bit", count, ns / count);
+} // benchmarkReference
+
+
+int main(int argc, char** argv) {
+	srand(1);
+	testItemStream(WS2812_OUTPUT_RMT);
+	testItemStream(WS2812_OUTPUT_RMT_STREAM);
+	testDitheredPowerLimit();
+	if (isBenchmark(argc, argv)) {
+		// The encode time is measured in us, long strips keep the rounding negligible.
+		benchmarkReference(10000);
+		benchmarkEncode(WS2812_OUTPUT_RMT, "RMT item table", 10000);
+		benchmarkEncode(WS2812_OUTPUT_SPI, "SPI nibble table", 10000);
+	}
+	return finishTest("test_encode");
+} // main
@@ -0,0 +1,166 @@
+/*
+ * HSB colors converted with integer arithmetic, compared with the double precision conversion
+ * the driver used to do.
+ */
+#include <stdlib.h>
+#include <vector>
+
+#include "WS2812.h"
+#include "host_test.h"
+#include "mock.h"
+
+
+/**
+ * @brief Convert an HSB color as the driver did with doubles.
+ */
+static pixel_t hsbReference(uint16_t hue, uint8_t saturation, uint8_t brightness) {
+	double sat[3];
+	if (hue < 120) {
+		sat[0] = (120 - hue) / 60.0;
+		sat[1] = hue / 60.0;
+		sat[2] = 0;
+	} else if (hue < 240) {
+		sat[0] = 0;
+		sat[1] = (240 - hue) / 60.0;
+		sat[2] = (hue - 120) / 60.0;
+	} else {
+		sat[0] = (hue - 240) / 60.0;
+		sat[1] = 0;
+		sat[2] = (360 - hue) / 60.0;
+	}
+
+	double  dSaturation = (double) saturation / 255;
+	double  dBrightness = (double) brightness / 255;
+	uint8_t channels[3];
+	for (int c = 0; c < 3; c++) {
+		if (sat[c] > 1.0) {
+			sat[c] = 1.0;
+		}
+		double ctmp = 2 * dSaturation * sat[c] + (1 - dSaturation);
+		double value;
+		if (dBrightness < 0.5) {
+			value = dBrightness * ctmp;
+		} else {
+			value = (1 - dBrightness) * ctmp + 2 * dBrightness - 1;
+		}
+		channels[c] = (uint8_t) (value * 255);
+	}
+
+	pixel_t pixel = { };
+	pixel.red   = channels[0];
+	pixel.green = channels[1];
+	pixel.blue  = channels[2];
+	return pixel;
+} // hsbReference
+
+
+static bool near(uint8_t expected, uint8_t actual) {
+	return abs((int) expected - (int) actual) <= 1;
+} // near
+
+
+static bool samePixel(pixel_t a, pixel_t b) {
+	return a.red == b.red && a.green == b.green && a.blue == b.blue;
+} // samePixel
+
+
+/**
+ * @brief Every hue, saturation and brightness converts within 1 of the double conversion.
+ */
+static void testConversion() {
+	uint32_t off = 0;
+	for (uint16_t hue = 0; hue < 360; hue++) {
+		for (int saturation = 0; saturation < 256; saturation++) {
+			for (int brightness = 0; brightness < 256; brightness++) {
+				pixel_t expected = hsbReference(hue, saturation, brightness);
+				pixel_t actual   = WS2812::hsbToPixel(hue, saturation, brightness);
+				if (!near(expected.red, actual.red) || !near(expected.green, actual.green)
+						|| !near(expected.blue, actual.blue)) {
+					if (off++ < 5) {
+						fprintf(stderr, "hsb(%u, %d, %d) is %u,%u,%u instead of %u,%u,%u\n", hue, saturation,
+							brightness, actual.red, actual.green, actual.blue, expected.red, expected.green,
+							expected.blue);
+					}
+				}
+			}
+		}
+	}
+	CHECK_EQUAL(0, off);
+	// Hues wrap around.
+	CHECK(samePixel(WS2812::hsbToPixel(10, 200, 100), WS2812::hsbToPixel(370, 200, 100)));
+	CHECK(samePixel(WS2812::hsbToPixel(0, 255, 128), WS2812::hsbToPixel(720, 255, 128)));
+} // testConversion
+
+
+/**
+ * @brief A range of hues sets the pixels as setting them one by one.
+ */
+static void testRange() {
+	const uint16_t count = 100;
+	WS2812* strip = new WS2812(GPIO_NUM_16, count, RMT_CHANNEL_0, WS2812_OUTPUT_RMT_STREAM);
+	const struct {
+		uint16_t from, to, hueFrom, hueTo;
+	} RANGES[] = {
+		{ 0, 100, 0, 360 },
+		{ 10, 30, 300, 420 },
+		{ 50, 51, 90, 90 },
+		{ 60, 90, 359, 0 },
+		{ 95, 100, 720, 1080 },
+	};
+	for (size_t r = 0; r < sizeof(RANGES) / sizeof(RANGES[0]); r++) {
+		strip->setHSBRange(RANGES[r].from, RANGES[r].to, RANGES[r].hueFrom, RANGES[r].hueTo, 200, 150);
+		uint16_t n    = RANGES[r].to - RANGES[r].from;
+		int32_t  span = (int32_t) RANGES[r].hueTo - RANGES[r].hueFrom;
+		for (uint16_t i = 0; i < n; i++) {
+			uint16_t hue = RANGES[r].hueFrom + span * i / n;
+			CHECK(samePixel(WS2812::hsbToPixel(hue, 200, 150), strip->getPixel(RANGES[r].from + i)));
+		}
+	}
+	// An empty range sets nothing.
+	pixel_t before = strip->getPixel(20);
+	strip->setHSBRange(20, 20, 0, 360, 0, 0);
+	CHECK(samePixel(before, strip->getPixel(20)));
+
+	strip->setHSBPixel(7, 123, 45, 67);
+	CHECK(samePixel(WS2812::hsbToPixel(123, 45, 67), strip->getPixel(7)));
+	delete strip;
+	mock_reset();
+} // testRange
+
+
+static void benchmarkHSB(uint16_t count) {
+	std::vector<pixel_t> pixels(count);
+	uint8_t brightness = 0;
+	double reference = benchmarkNs(200, [&]() {
+		brightness++;
+		for (uint16_t i = 0; i < count; i++) {
+			pixels[i] = hsbReference(i * 360 / count, 200, brightness);
+		}
+	});
+	double integer = benchmarkNs(200, [&]() {
+		brightness++;
+		for (uint16_t i = 0; i < count; i++) {
+			pixels[i] = WS2812::hsbToPixel(i * 360 / count, 200, brightness);
+		}
+	});
+	WS2812* strip = new WS2812(GPIO_NUM_16, count, RMT_CHANNEL_0, WS2812_OUTPUT_RMT_STREAM);
+	double range = benchmarkNs(200, [&]() {
+		brightness++;
+		strip->setHSBRange(0, count, 0, 360, 200, brightness);
+	});
+	printf("%-20s %6u pixels: %6.2f ns/pixel\n", "HSB with doubles", count, reference / count);
+	printf("%-20s %6u pixels: %6.2f ns/pixel\n", "hsbToPixel", count, integer / count);
+	printf("%-20s %6u pixels: %6.2f ns/pixel\n", "setHSBRange", count, range / count);
+	delete strip;
+	mock_reset();
+} // benchmarkHSB
+
+
+int main(int argc, char** argv) {
+	testConversion();
+	testRange();
+	if (isBenchmark(argc, argv)) {
+		benchmarkHSB(10000);
+	}
+	return finishTest("test_hsb");
+} // main
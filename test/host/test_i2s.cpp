@@ -0,0 +1,222 @@
+/*
+ * Bit planes of the I2S output: the transpose kernels compared with moving one bit at a time,
+ * and the waveform of each pin compared with the levels sent by the RMT for the same pixels.
+ */
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+#include "BitTranspose.h"
+#include "WS2812.h"
+#include "WS2812I2S.h"
+#include "host_test.h"
+#include "mock.h"
+#include "waveform.h"
+
+static const int I2S_PORT = 1;
+
+
+/**
+ * @brief Transpose bytes into bit planes one bit at a time: bit s of planes[k] is bit 7 - k of
+ * bytes[s].
+ */
+static void transposeReference(const uint8_t* bytes, uint8_t count, uint16_t* planes) {
+	for (uint8_t k = 0; k < 8; k++) {
+		planes[k] = 0;
+		for (uint8_t s = 0; s < count; s++) {
+			planes[k] |= ((bytes[s] >> (7 - k)) & 1) << s;
+		}
+	}
+} // transposeReference
+
+
+static std::vector<pixel_t> randomPixels(uint16_t count, bool white) {
+	std::vector<pixel_t> pixels(count);
+	for (uint16_t i = 0; i < count; i++) {
+		pixels[i].red   = rand();
+		pixels[i].green = rand();
+		pixels[i].blue  = rand();
+		pixels[i].white = white ? rand() : 0;
+	}
+	return pixels;
+} // randomPixels
+
+
+static void testTranspose() {
+	uint8_t  bytes[16];
+	uint8_t  bytePlanes[8];
+	uint16_t wordPlanes[8];
+	uint16_t expected[8];
+	for (int i = 0; i < 10000; i++) {
+		for (uint8_t s = 0; s < 16; s++) {
+			bytes[s] = rand();
+		}
+		transposeReference(bytes, 8, expected);
+		transpose8x8(bytes, bytePlanes);
+		for (uint8_t k = 0; k < 8; k++) {
+			CHECK_EQUAL(expected[k], bytePlanes[k]);
+		}
+		transposeReference(bytes, 16, expected);
+		transpose16x8(bytes, wordPlanes);
+		for (uint8_t k = 0; k < 8; k++) {
+			CHECK_EQUAL(expected[k], wordPlanes[k]);
+		}
+	}
+} // testTranspose
+
+
+/**
+ * @brief Each pin sends the levels of its segment, as the RMT sends them for the whole strip.
+ *
+ * The last segment is shorter and is padded with black pixels.
+ */
+static void testSegments(ws2812_type_t type, const gpio_num_t* pins, uint8_t pinCount, uint16_t count) {
+	WS2812I2S* strips    = new WS2812I2S(pins, pinCount, count, I2S_PORT, type);
+	WS2812*    reference = new WS2812(GPIO_NUM_16, count, RMT_CHANNEL_0, WS2812_OUTPUT_RMT_STREAM, 0, type);
+	const uint8_t channelCount = reference->getChannelCount();
+	reference->setWhiteExtraction(false);
+	reference->setBrightness(200);
+	reference->setGamma(2.2);
+	strips->setWhiteExtraction(false);
+	strips->setBrightness(200);
+	strips->setGamma(2.2);
+
+	std::vector<pixel_t> pixels = randomPixels(count, channelCount == 4);
+	for (uint16_t i = 0; i < count; i++) {
+		strips->setPixel(i, pixels[i]);
+		reference->setPixel(i, pixels[i]);
+	}
+	// A frame stopped before the FIFO drains is never reported sent, and the strips can then
+	// not be deleted.
+	strips->showAsync();
+	if (!strips->waitShowComplete(pdMS_TO_TICKS(100))) {
+		fprintf(stderr, "%s: the frame is never reported sent\n", getBitWindow(type)->name);
+		s_failures++;
+		exit(finishTest("test_i2s"));
+	}
+	reference->show();
+
+	decoded_t wire;
+	CHECK(decodeWaveform(waveformFromItems(mock_rmt[RMT_CHANNEL_0].items, mock_rmt_tick_ns(RMT_CHANNEL_0)),
+		getBitWindow(type), &wire));
+	CHECK_EQUAL(1, mock_i2s[I2S_PORT].frames);
+	CHECK(mock_i2s[I2S_PORT].stopped);
+
+	const uint16_t segmentLength = (count + pinCount - 1) / pinCount;
+	const double   slotNs        = mock_i2s_slot_ns(I2S_PORT);
+	for (uint8_t s = 0; s < pinCount; s++) {
+		CHECK_EQUAL(pins[s], mock_i2s[I2S_PORT].pins[s]);
+		std::vector<uint8_t> expected(segmentLength * channelCount, 0);
+		size_t first = (size_t) s * segmentLength * channelCount;
+		for (size_t i = first; i < wire.bytes.size() && i < first + expected.size(); i++) {
+			expected[i - first] = wire.bytes[i];
+		}
+		decoded_t decoded;
+		if (!decodeWaveform(waveformFromSlots(mock_i2s[I2S_PORT].slots, s, slotNs), getBitWindow(type), &decoded)) {
+			fprintf(stderr, "%s, pin %u of %u: %s\n", getBitWindow(type)->name, s, pinCount, decoded.error.c_str());
+			s_failures++;
+		}
+		CHECK(decoded.bytes == expected);
+		CHECK(decoded.resetNs >= getBitWindow(type)->resetMin);
+	}
+	// The unused data bits stay low.
+	for (size_t i = 0; i < mock_i2s[I2S_PORT].slots.size(); i++) {
+		CHECK_EQUAL(0, mock_i2s[I2S_PORT].slots[i] >> pinCount);
+	}
+	delete reference;
+	delete strips;
+	mock_reset();
+} // testSegments
+
+
+/**
+ * @brief A frame shown while the previous one is being sent waits for it.
+ */
+static void testStall() {
+	const gpio_num_t pins[] = { GPIO_NUM_16, GPIO_NUM_17 };
+	WS2812I2S* strips = new WS2812I2S(pins, 2, 10, I2S_PORT);
+	ws2812_stats_t before;
+	strips->getStats(&before);
+	strips->showAsync();
+	strips->showAsync();
+	CHECK(strips->waitShowComplete());
+	ws2812_stats_t after;
+	strips->getStats(&after);
+	CHECK_EQUAL(1, after.stalledFrames - before.stalledFrames);
+	CHECK_EQUAL(2, mock_i2s[I2S_PORT].frames);
+	delete strips;
+	mock_reset();
+} // testStall
+
+
+static void benchmarkTranspose(uint16_t rows) {
+	std::vector<uint8_t> bytes(rows * 3 * 16);
+	for (size_t i = 0; i < bytes.size(); i++) {
+		bytes[i] = rand();
+	}
+	std::vector<uint16_t> planes(bytes.size() / 2);
+	double reference = benchmarkNs(100, [&]() {
+		for (size_t i = 0; i < bytes.size(); i += 16) {
+			transposeReference(&bytes[i], 16, &planes[i / 2]);
+		}
+	});
+	double kernel = benchmarkNs(100, [&]() {
+		for (size_t i = 0; i < bytes.size(); i += 16) {
+			transpose16x8(&bytes[i], &planes[i / 2]);
+		}
+	});
+	uint32_t pixels = rows * 16;
+	printf("%-28s %6u pixels: %8.2f Mpixels/s\n", "Transpose bit by bit", pixels, pixels * 1e3 / reference);
+	printf("%-28s %6u pixels: %8.2f Mpixels/s\n", "Transpose 16x8", pixels, pixels * 1e3 / kernel);
+} // benchmarkTranspose
+
+
+/**
+ * @brief Time spent by showAsync() encoding and transposing a frame of 16 strips, compared with
+ * the rate at which I2S clocks the frames out.
+ */
+static void benchmarkShow(uint16_t segmentLength) {
+	gpio_num_t pins[16];
+	for (uint8_t s = 0; s < 16; s++) {
+		pins[s] = (gpio_num_t) s;
+	}
+	uint16_t   count  = segmentLength * 16;
+	WS2812I2S* strips = new WS2812I2S(pins, 16, count, I2S_PORT);
+	std::vector<pixel_t> pixels = randomPixels(count, false);
+	const uint32_t frames = 100;
+	double showNs = 0;
+	for (uint32_t frame = 0; frame < frames; frame++) {
+		for (uint16_t i = 0; i < count; i++) {
+			pixels[i].red += 1;
+			strips->setPixel(i, pixels[i]);
+		}
+		// The previous frame has been sent, so showAsync() does not wait.
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		strips->showAsync();
+		showNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		strips->waitShowComplete();
+	}
+	double frameNs = mock_i2s[I2S_PORT].slots.size() * mock_i2s_slot_ns(I2S_PORT);
+	printf("%-28s %6u pixels: %8.2f Mpixels/s\n", "showAsync, 16 pins", count, count * 1e3 * frames / showNs);
+	printf("%-28s %6u pixels: %8.2f Mpixels/s\n", "I2S output, 16 pins", count, count * 1e3 / frameNs);
+	delete strips;
+	mock_reset();
+} // benchmarkShow
+
+
+int main(int argc, char** argv) {
+	srand(1);
+	testTranspose();
+	const gpio_num_t fewPins[]  = { GPIO_NUM_1, GPIO_NUM_3, GPIO_NUM_8, GPIO_NUM_11, GPIO_NUM_16 };
+	const gpio_num_t manyPins[] = { GPIO_NUM_0, GPIO_NUM_2, GPIO_NUM_4, GPIO_NUM_5, GPIO_NUM_12, GPIO_NUM_13,
+		GPIO_NUM_14, GPIO_NUM_15, GPIO_NUM_16, GPIO_NUM_17, GPIO_NUM_18, GPIO_NUM_19 };
+	testSegments(WS2812_TYPE_WS2812, fewPins, 5, 37);
+	testSegments(WS2812_TYPE_SK6812_RGBW, fewPins, 5, 37);
+	testSegments(WS2812_TYPE_WS2813, manyPins, 12, 100);
+	testStall();
+	if (isBenchmark(argc, argv)) {
+		benchmarkTranspose(600);
+		benchmarkShow(600);
+	}
+	return finishTest("test_i2s");
+} // main
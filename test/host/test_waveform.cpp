@@ -0,0 +1,292 @@
+/*
+ * Waveforms sent by the WS2812 outputs: every bit of every LED type within its timing window,
+ * carrying the pixels in the color order of the type.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "WS2812.h"
+#include "WS2812Parallel.h"
+#include "host_test.h"
+#include "mock.h"
+#include "waveform.h"
+
+static const ws2812_type_t TYPES[] = {
+	WS2812_TYPE_WS2812, WS2812_TYPE_WS2811, WS2812_TYPE_WS2813, WS2812_TYPE_SK6812, WS2812_TYPE_SK6812_RGBW
+};
+
+static const char* DEFAULT_ORDERS[] = { "GRB", "RGB", "GRB", "GRB", "GRBW" };
+
+static const uint16_t PIXEL_COUNT = 50;
+
+
+static uint8_t getChannel(pixel_t pixel, char channel) {
+	switch (channel) {
+		case 'R': return pixel.red;
+		case 'G': return pixel.green;
+		case 'B': return pixel.blue;
+		default:  return pixel.white;
+	}
+} // getChannel
+
+
+static std::vector<pixel_t> randomPixels(uint16_t count, bool white) {
+	std::vector<pixel_t> pixels(count);
+	for (uint16_t i = 0; i < count; i++) {
+		pixels[i].red   = rand();
+		pixels[i].green = rand();
+		pixels[i].blue  = rand();
+		pixels[i].white = white ? rand() : 0;
+	}
+	return pixels;
+} // randomPixels
+
+
+static void setPixels(WS2812* strip, const std::vector<pixel_t>& pixels) {
+	for (uint16_t i = 0; i < pixels.size(); i++) {
+		strip->setPixel(i, pixels[i]);
+	}
+} // setPixels
+
+
+/**
+ * @brief The bytes the LEDs should read for pixels, in the given color order.
+ */
+static std::vector<uint8_t> getWireBytes(const std::vector<pixel_t>& pixels, const char* order) {
+	std::vector<uint8_t> bytes;
+	for (size_t i = 0; i < pixels.size(); i++) {
+		for (const char* channel = order; *channel != 0; channel++) {
+			bytes.push_back(getChannel(pixels[i], *channel));
+		}
+	}
+	return bytes;
+} // getWireBytes
+
+
+static bool decodeRMT(rmt_channel_t channel, ws2812_type_t type, decoded_t* pDecoded) {
+	waveform_t waveform = waveformFromItems(mock_rmt[channel].items, mock_rmt_tick_ns(channel));
+	return decodeWaveform(waveform, getBitWindow(type), pDecoded);
+} // decodeRMT
+
+
+static bool decodeSPI(spi_host_device_t host, ws2812_type_t type, decoded_t* pDecoded) {
+	waveform_t waveform = waveformFromBits(mock_spi[host].bytes, mock_spi_bit_ns(host));
+	return decodeWaveform(waveform, getBitWindow(type), pDecoded);
+} // decodeSPI
+
+
+static void checkFrame(bool valid, const decoded_t& decoded, const std::vector<uint8_t>& expected,
+		ws2812_type_t type, const char* output) {
+	if (!valid) {
+		fprintf(stderr, "%s on %s: %s\n", output, getBitWindow(type)->name, decoded.error.c_str());
+	}
+	CHECK(valid);
+	CHECK(decoded.bytes == expected);
+} // checkFrame
+
+
+static void testDecoder() {
+	const bit_window_t* window = getBitWindow(WS2812_TYPE_WS2812);
+	decoded_t decoded;
+
+	// 0xA5 and 0x0F with a "1" of 800ns and a "0" of 400ns.
+	waveform_t waveform;
+	for (uint16_t bits = 0xA50F, i = 0; i < 16; i++, bits <<= 1) {
+		bool one = bits & 0x8000;
+		appendLevel(&waveform, true, one ? 800 : 400);
+		appendLevel(&waveform, false, one ? 450 : 850);
+	}
+	appendLevel(&waveform, false, 60000);
+	CHECK(decodeWaveform(waveform, window, &decoded));
+	CHECK_EQUAL(2, decoded.bytes.size());
+	CHECK_EQUAL(0xA5, decoded.bytes[0]);
+	CHECK_EQUAL(0x0F, decoded.bytes[1]);
+	CHECK(decoded.resetNs >= window->resetMin);
+
+	waveform_t between = waveform;
+	between[0].ns = 540;
+	CHECK(!decodeWaveform(between, window, &decoded));
+
+	waveform_t latched = waveform;
+	latched[3].ns = 60000;
+	CHECK(!decodeWaveform(latched, window, &decoded));
+
+	waveform_t incomplete(waveform.begin() + 2, waveform.end());
+	CHECK(!decodeWaveform(incomplete, window, &decoded));
+
+	// The RMT stops at the first duration of 0.
+	std::vector<rmt_item32_t> items(3);
+	for (size_t i = 0; i < items.size(); i++) {
+		items[i].level0 = 1;
+		items[i].duration0 = 4;
+		items[i].level1 = 0;
+		items[i].duration1 = 8;
+	}
+	items[1].duration0 = 0;
+	CHECK_EQUAL(2, waveformFromItems(items, 100).size());
+} // testDecoder
+
+
+static void testRMT(ws2812_output_t output, const char* name) {
+	for (uint8_t t = 0; t < sizeof(TYPES) / sizeof(TYPES[0]); t++) {
+		ws2812_type_t type = TYPES[t];
+		WS2812* strip = new WS2812(GPIO_NUM_16, PIXEL_COUNT, RMT_CHANNEL_0, output, 0, type);
+		strip->setWhiteExtraction(false);
+		std::vector<pixel_t> pixels = randomPixels(PIXEL_COUNT, strlen(DEFAULT_ORDERS[t]) == 4);
+		setPixels(strip, pixels);
+		strip->show();
+
+		decoded_t decoded;
+		bool valid = decodeRMT(RMT_CHANNEL_0, type, &decoded);
+		checkFrame(valid, decoded, getWireBytes(pixels, DEFAULT_ORDERS[t]), type, name);
+
+		// Only the changed pixel is encoded again, the frame sent is still whole.
+		pixels[7].red = ~pixels[7].red;
+		strip->setPixel(7, pixels[7]);
+		strip->show();
+		valid = decodeRMT(RMT_CHANNEL_0, type, &decoded);
+		checkFrame(valid, decoded, getWireBytes(pixels, DEFAULT_ORDERS[t]), type, name);
+		CHECK_EQUAL(1, strip->getEncodedPixelCount());
+		CHECK_EQUAL(2, mock_rmt[RMT_CHANNEL_0].frames);
+		delete strip;
+		mock_reset();
+	}
+} // testRMT
+
+
+static void testSPI() {
+	for (uint8_t t = 0; t < sizeof(TYPES) / sizeof(TYPES[0]); t++) {
+		ws2812_type_t type = TYPES[t];
+		WS2812* strip = new WS2812(GPIO_NUM_16, PIXEL_COUNT, HSPI_HOST, WS2812_OUTPUT_SPI, 0, type);
+		strip->setWhiteExtraction(false);
+		std::vector<pixel_t> pixels = randomPixels(PIXEL_COUNT, strlen(DEFAULT_ORDERS[t]) == 4);
+		setPixels(strip, pixels);
+		strip->show();
+
+		// The bits of each type fit its window, and the frame ends with its own reset.
+		decoded_t decoded;
+		bool valid = decodeSPI(HSPI_HOST, type, &decoded);
+		checkFrame(valid, decoded, getWireBytes(pixels, DEFAULT_ORDERS[t]), type, "SPI");
+		CHECK(decoded.resetNs >= getBitWindow(type)->resetMin);
+		delete strip;
+		mock_reset();
+	}
+} // testSPI
+
+
+static void testAsync() {
+	// Both output buffers carry whole frames.
+	WS2812* strip = new WS2812(GPIO_NUM_16, PIXEL_COUNT, RMT_CHANNEL_0, WS2812_OUTPUT_RMT);
+	std::vector<pixel_t> pixels = randomPixels(PIXEL_COUNT, false);
+	for (int frame = 0; frame < 4; frame++) {
+		pixels[frame * 5].blue = frame;
+		setPixels(strip, pixels);
+		strip->showAsync();
+		strip->waitShowComplete();
+		decoded_t decoded;
+		bool valid = decodeRMT(RMT_CHANNEL_0, WS2812_TYPE_WS2812, &decoded);
+		checkFrame(valid, decoded, getWireBytes(pixels, "GRB"), WS2812_TYPE_WS2812, "RMT async");
+	}
+	delete strip;
+	mock_reset();
+} // testAsync
+
+
+static WS2812Parallel*      s_parallel;
+static std::vector<pixel_t> s_nextPixels; // Pixels set as the segments start.
+static std::vector<int>     s_started;    // Channels in the order their frames started.
+
+
+/**
+ * @brief Called as a segment starts its frame: every pixel changes, which only the next frame
+ * may show if all the segments were encoded first.
+ */
+static void onSegmentStart(rmt_channel_t channel) {
+	s_started.push_back(channel);
+	for (uint16_t i = 0; i < s_nextPixels.size(); i++) {
+		s_parallel->setPixel(i, s_nextPixels[i]);
+	}
+} // onSegmentStart
+
+
+/**
+ * @brief Check that each segment of a parallel strip sent its own range of pixels.
+ */
+static void checkSegments(const std::vector<pixel_t>& pixels, uint16_t segmentLength, uint8_t memBlocks) {
+	for (uint8_t i = 0; i < s_parallel->getOutputCount(); i++) {
+		rmt_channel_t channel = (rmt_channel_t) (i * memBlocks);
+		size_t first = i * segmentLength;
+		size_t last  = first + segmentLength < pixels.size() ? first + segmentLength : pixels.size();
+		std::vector<pixel_t> segment(pixels.begin() + first, pixels.begin() + last);
+		decoded_t decoded;
+		bool valid = decodeRMT(channel, WS2812_TYPE_WS2812, &decoded);
+		checkFrame(valid, decoded, getWireBytes(segment, "GRB"), WS2812_TYPE_WS2812, "RMT parallel");
+	}
+} // checkSegments
+
+
+static void testParallel() {
+	static const gpio_num_t PINS[] = { GPIO_NUM_16, GPIO_NUM_17, GPIO_NUM_18, GPIO_NUM_19 };
+	// Segments of 13 pixels, the last one of 11, then 3 segments of 2 pixels and an unused pin.
+	static const uint16_t COUNTS[] = { PIXEL_COUNT, 5 };
+	for (uint16_t count : COUNTS) {
+		s_parallel = new WS2812Parallel(PINS, 4, count);
+		const uint16_t segmentLength = (count + 3) / 4;
+		const uint8_t  outputs   = (count + segmentLength - 1) / segmentLength;
+		const uint8_t  memBlocks = RMT_CHANNEL_MAX / outputs;
+		CHECK_EQUAL(outputs, s_parallel->getOutputCount());
+		for (uint8_t i = 0; i < outputs; i++) {
+			rmt_channel_t channel = (rmt_channel_t) (i * memBlocks);
+			CHECK_EQUAL(PINS[i], mock_rmt[channel].config.gpio_num);
+			CHECK_EQUAL(memBlocks, mock_rmt[channel].config.mem_block_num);
+		}
+
+		std::vector<pixel_t> pixels = randomPixels(count, false);
+		for (uint16_t i = 0; i < count; i++) {
+			s_parallel->setPixel(i, pixels[i]);
+		}
+		s_nextPixels = randomPixels(count, false);
+		s_started.clear();
+		mock_set_rmt_start_hook(onSegmentStart);
+		s_parallel->showAsync();
+		mock_set_rmt_start_hook(nullptr);
+		CHECK(s_parallel->waitShowComplete());
+
+		// The segments start one after the other, in pixel order, all of them already encoded.
+		CHECK_EQUAL(outputs, s_started.size());
+		for (uint8_t i = 0; i < outputs && i < s_started.size(); i++) {
+			CHECK_EQUAL(i * memBlocks, s_started[i]);
+		}
+		checkSegments(pixels, segmentLength, memBlocks);
+
+		// The pixels set as the segments started make the next frame.
+		s_parallel->show();
+		checkSegments(s_nextPixels, segmentLength, memBlocks);
+		delete s_parallel;
+		mock_reset();
+	}
+} // testParallel
+
+
+static void testEmptyStrip() {
+	WS2812* strip = new WS2812(GPIO_NUM_16, 0, RMT_CHANNEL_0, WS2812_OUTPUT_RMT);
+	strip->clear();
+	strip->show();
+	CHECK_EQUAL(0, mock_rmt[RMT_CHANNEL_0].items.size());
+	delete strip;
+	mock_reset();
+} // testEmptyStrip
+
+
+int main(int argc, char** argv) {
+	srand(1);
+	testDecoder();
+	testRMT(WS2812_OUTPUT_RMT, "RMT");
+	testRMT(WS2812_OUTPUT_RMT_STREAM, "RMT stream");
+	testSPI();
+	testAsync();
+	testParallel();
+	testEmptyStrip();
+	return finishTest("test_waveform");
+} // main
@@ -0,0 +1,138 @@
+#include <math.h>
+#include <stdio.h>
+
+#include "waveform.h"
+
+/**
+ * The bit windows of each ws2812_type_t.  The WS2811 and SK6812 high times are their datasheet
+ * tolerances, +-150ns.  The WS2812 and WS2813 ones are those the LEDs are known to read
+ * correctly, somewhat wider than the datasheet tolerances: the LEDs sample the line at a fixed
+ * delay after the rising edge.  A low time longer than tlMax may already latch the frame.
+ */
+static const bit_window_t BIT_WINDOWS[] = {
+	/* WS2812_TYPE_WS2812 */      { "WS2812",      200, 500, 580, 1250, 300, 5000, 50000 },
+	/* WS2812_TYPE_WS2811 */      { "WS2811",      100, 400, 450, 750,  300, 5000, 50000 },
+	/* WS2812_TYPE_WS2813 */      { "WS2813",      220, 500, 580, 1250, 300, 5000, 280000 },
+	/* WS2812_TYPE_SK6812 */      { "SK6812",      150, 450, 450, 750,  300, 5000, 80000 },
+	/* WS2812_TYPE_SK6812_RGBW */ { "SK6812 RGBW", 150, 450, 450, 750,  300, 5000, 80000 },
+};
+
+
+const bit_window_t* getBitWindow(ws2812_type_t type) {
+	return &BIT_WINDOWS[type];
+} // getBitWindow
+
+
+/**
+ * @brief Append a level to a waveform, merged with the last one if they are the same.
+ */
+void appendLevel(waveform_t* pWaveform, bool high, double ns) {
+	if (ns <= 0) {
+		return;
+	}
+	if (!pWaveform->empty() && pWaveform->back().high == high) {
+		pWaveform->back().ns += ns;
+		return;
+	}
+	level_t level = { high, ns };
+	pWaveform->push_back(level);
+} // appendLevel
+
+
+/**
+ * @brief The waveform of RMT items.  As the RMT, stops at the first duration of 0.
+ */
+waveform_t waveformFromItems(const std::vector<rmt_item32_t>& items, double tickNs) {
+	waveform_t waveform;
+	for (size_t i = 0; i < items.size(); i++) {
+		if (items[i].duration0 == 0) {
+			break;
+		}
+		appendLevel(&waveform, items[i].level0, items[i].duration0 * tickNs);
+		if (items[i].duration1 == 0) {
+			break;
+		}
+		appendLevel(&waveform, items[i].level1, items[i].duration1 * tickNs);
+	}
+	return waveform;
+} // waveformFromItems
+
+
+/**
+ * @brief The waveform of bytes shifted out most significant bit first, as on SPI MOSI.
+ */
+waveform_t waveformFromBits(const std::vector<uint8_t>& bytes, double bitNs) {
+	waveform_t waveform;
+	for (size_t i = 0; i < bytes.size(); i++) {
+		for (int bit = 7; bit >= 0; bit--) {
+			appendLevel(&waveform, (bytes[i] >> bit) & 1, bitNs);
+		}
+	}
+	return waveform;
+} // waveformFromBits
+
+
+/**
+ * @brief The waveform of one data bit of the slots clocked out by I2S in parallel.
+ */
+waveform_t waveformFromSlots(const std::vector<uint16_t>& slots, uint8_t bit, double slotNs) {
+	waveform_t waveform;
+	for (size_t i = 0; i < slots.size(); i++) {
+		appendLevel(&waveform, (slots[i] >> bit) & 1, slotNs);
+	}
+	return waveform;
+} // waveformFromSlots
+
+
+static bool fail(decoded_t* pDecoded, size_t bit, const char* what, double ns) {
+	char error[96];
+	snprintf(error, sizeof(error), "bit %u: %s for %.0fns", (unsigned) bit, what, ns);
+	pDecoded->error = error;
+	return false;
+} // fail
+
+
+/**
+ * @brief Decode a waveform into the bytes the LEDs read from it.
+ *
+ * The line is low before and after the waveform.  Each bit is a high level followed by a low
+ * one, which only latches the frame after the last bit.
+ *
+ * @return True if every bit is within the window and the waveform holds whole bytes.
+ */
+bool decodeWaveform(const waveform_t& waveform, const bit_window_t* window, decoded_t* pDecoded) {
+	pDecoded->bytes.clear();
+	pDecoded->resetNs = 0;
+	pDecoded->error.clear();
+
+	size_t  i     = (!waveform.empty() && !waveform[0].high) ? 1 : 0;
+	size_t  bit   = 0;
+	uint8_t value = 0;
+	for (; i < waveform.size(); i += 2, bit++) {
+		double high = waveform[i].ns;
+		if (high >= window->t0hMin && high <= window->t0hMax) {
+			value <<= 1;
+		} else if (high >= window->t1hMin && high <= window->t1hMax) {
+			value = (value << 1) | 1;
+		} else {
+			return fail(pDecoded, bit, "high", high);
+		}
+		if (bit % 8 == 7) {
+			pDecoded->bytes.push_back(value);
+		}
+
+		bool   last = i + 2 >= waveform.size();
+		double low  = i + 1 < waveform.size() ? waveform[i + 1].ns : 0;
+		if (last) {
+			pDecoded->resetNs = low;
+		} else if (low >= window->resetMin) {
+			return fail(pDecoded, bit, "latched by a low", low);
+		} else if (low < window->tlMin || low > window->tlMax) {
+			return fail(pDecoded, bit, "low", low);
+		}
+	}
+	if (bit % 8 != 0) {
+		return fail(pDecoded, bit, "incomplete byte, line idle", pDecoded->resetNs);
+	}
+	return true;
+} // decodeWaveform
@@ -0,0 +1,58 @@
+/*
+ * Decoding of the data line waveforms sent to the LEDs, as the LEDs read them.
+ *
+ * The outputs of the drivers captured by the mocks are turned into a waveform, a list of levels
+ * and their durations, then decoded back into bytes while checking the timing of every bit
+ * against the windows of the LED type.
+ */
+#ifndef HOST_WAVEFORM_H_
+#define HOST_WAVEFORM_H_
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <driver/rmt.h>
+
+#include "WS2812.h"
+
+/**
+ * @brief A level held on the data line, for a duration in ns.
+ */
+typedef struct {
+	bool   high;
+	double ns;
+} level_t;
+
+typedef std::vector<level_t> waveform_t;
+
+/**
+ * @brief The timings within which an LED type reads a bit, in ns.
+ */
+typedef struct {
+	const char* name;
+	double t0hMin;    // High time of a "0".
+	double t0hMax;
+	double t1hMin;    // High time of a "1".
+	double t1hMax;
+	double tlMin;     // Low time following a bit within a frame.
+	double tlMax;
+	double resetMin;  // Low time latching the frame.
+} bit_window_t;
+
+/**
+ * @brief The bytes read by the LEDs from a waveform.
+ */
+typedef struct {
+	std::vector<uint8_t> bytes;
+	double resetNs;      // Low time ending the waveform.
+	std::string error;   // Why the waveform is not a valid frame, empty if it is.
+} decoded_t;
+
+const bit_window_t* getBitWindow(ws2812_type_t type);
+
+void appendLevel(waveform_t* pWaveform, bool high, double ns);
+waveform_t waveformFromItems(const std::vector<rmt_item32_t>& items, double tickNs);
+waveform_t waveformFromBits(const std::vector<uint8_t>& bytes, double bitNs);
+waveform_t waveformFromSlots(const std::vector<uint16_t>& slots, uint8_t bit, double slotNs);
+bool decodeWaveform(const waveform_t& waveform, const bit_window_t* window, decoded_t* pDecoded);
+
+#endif